@@ -0,0 +1,116 @@
+/*
+ * AdmissionControl.cpp
+ * Purpose: Process-wide count of the admitted sessions, in total and per client IP address, checked
+ *          against the configured caps before a session is created. An admitted session holds a ticket
+ *          that gives its place back when the session closes. The total is a single atomic counter; the
+ *          per-address counts are spread over striped maps, so shards rarely contend for a lock, and
+ *          addresses are only tracked while a per-address cap is set.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "AdmissionControl.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace {
+    AdmissionControl::Source to_source(const boost::asio::ip::address& address) {
+        if (address.is_v4()) {
+            return boost::asio::ip::make_address_v6(boost::asio::ip::v4_mapped, address.to_v4()).to_bytes();
+        }
+        return address.to_v6().to_bytes();
+    }
+}
+
+AdmissionControl::Ticket::Ticket(Ticket&& other) noexcept
+    : control_(std::exchange(other.control_, nullptr)),
+    source_(other.source_),
+    counts_source_(other.counts_source_) {
+}
+
+AdmissionControl::Ticket::~Ticket() {
+    release();
+}
+
+AdmissionControl::Ticket& AdmissionControl::Ticket::operator = (Ticket&& other) noexcept {
+    if (this != &other) {
+        release();
+        control_ = std::exchange(other.control_, nullptr);
+        source_ = other.source_;
+        counts_source_ = other.counts_source_;
+    }
+    return *this;
+}
+
+void AdmissionControl::Ticket::release() {
+    if (control_ != nullptr) {
+        control_->release(*this);
+        control_ = nullptr;
+    }
+}
+
+AdmissionControl::Verdict AdmissionControl::admit(const boost::asio::ip::address& source, std::size_t max_sessions, std::size_t max_sessions_per_source, Ticket& ticket) {
+    ticket.release();
+
+    // The place is taken first and handed back if it was over the cap, so concurrent admissions never overshoot.
+    const std::size_t count = session_count_.fetch_add(1, std::memory_order_relaxed);
+    if (max_sessions != 0 && count >= max_sessions) {
+        session_count_.fetch_sub(1, std::memory_order_relaxed);
+        return Verdict::Session_Limit;
+    }
+
+    ticket.counts_source_ = max_sessions_per_source != 0;
+    if (ticket.counts_source_) {
+        ticket.source_ = to_source(source);
+        Stripe& counts = stripe(ticket.source_);
+        const std::lock_guard<std::mutex> lock(counts.mutex);
+        const auto entry = counts.sessions.find(ticket.source_);
+        if (entry == counts.sessions.end()) {
+            counts.sessions.emplace(ticket.source_, 1);
+        }
+        else if (entry->second >= max_sessions_per_source) {
+            session_count_.fetch_sub(1, std::memory_order_relaxed);
+            return Verdict::Source_Limit;
+        }
+        else {
+            ++entry->second;
+        }
+    }
+
+    ticket.control_ = this;
+    return Verdict::Admitted;
+}
+
+std::size_t AdmissionControl::session_count() const {
+    return session_count_.load(std::memory_order_relaxed);
+}
+
+std::size_t AdmissionControl::Source_Hash::operator () (const Source& source) const {
+    std::uint64_t high;
+    std::uint64_t low;
+    std::memcpy(&high, source.data(), sizeof(high));
+    std::memcpy(&low, source.data() + sizeof(high), sizeof(low));
+    // Mixes both halves, so IPv4-mapped addresses, which share the upper half, still spread over the stripes.
+    const std::uint64_t hash = (high ^ (low * 0x9E3779B97F4A7C15ull)) * 0xFF51AFD7ED558CCDull;
+    return static_cast<std::size_t>(hash ^ (hash >> 32));
+}
+
+void AdmissionControl::release(const Ticket& ticket) {
+    if (ticket.counts_source_) {
+        Stripe& counts = stripe(ticket.source_);
+        const std::lock_guard<std::mutex> lock(counts.mutex);
+        const auto entry = counts.sessions.find(ticket.source_);
+        if (entry != counts.sessions.end() && --entry->second == 0) {
+            counts.sessions.erase(entry);
+        }
+    }
+    session_count_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+AdmissionControl::Stripe& AdmissionControl::stripe(const Source& source) {
+    // The map of a stripe hashes the full value; the stripe is picked from its upper bits so the two stay independent.
+    return stripes_[(Source_Hash()(source) >> 26) % STRIPE_COUNT];
+}
@@ -0,0 +1,114 @@
+/*
+ * AdmissionControl.h
+ * Purpose: Process-wide count of the admitted sessions, in total and per client IP address, checked
+ *          against the configured caps before a session is created. An admitted session holds a ticket
+ *          that gives its place back when the session closes. The total is a single atomic counter; the
+ *          per-address counts are spread over striped maps, so shards rarely contend for a lock, and
+ *          addresses are only tracked while a per-address cap is set.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <boost/asio.hpp>
+
+class AdmissionControl {
+public:
+    // Client address as 16 bytes, IPv4 addresses mapped into IPv6.
+    using Source = std::array<unsigned char, 16>;
+
+    enum class Verdict {
+        Admitted,
+        Session_Limit, // The proxy runs the maximum number of sessions.
+        Source_Limit   // The client address runs the maximum number of sessions.
+    };
+
+    // Place of an admitted session. Moving it transfers the place; releasing or destroying it gives the place back.
+    class Ticket {
+    public:
+        Ticket() = default;
+
+        Ticket(Ticket&& other) noexcept;
+
+        /*
+         * Destructor. Releases the place if it is still held.
+         */
+        ~Ticket();
+
+        Ticket& operator = (Ticket&& other) noexcept;
+
+        /*
+         * Gives the place back. Safe to call more than once.
+         */
+        void release();
+
+    private:
+        friend class AdmissionControl;
+
+        AdmissionControl* control_ = nullptr;
+        Source source_{};
+        bool counts_source_ = false; // Whether the place is counted against the client address.
+    };
+
+    AdmissionControl() = default;
+
+    // Delete copy constructor to prevent unintended copying.
+    AdmissionControl(const AdmissionControl&) = delete;
+
+    // Delete assignment operator to prevent unintended copying.
+    AdmissionControl& operator = (const AdmissionControl&) = delete;
+
+    /*
+     * Admits a session if neither cap is reached. Never allocates when the session is rejected. Safe to call from any thread.
+     *
+     * @param[in] source: The client address.
+     * @param[in] max_sessions: The maximum number of sessions, 0 for no limit.
+     * @param[in] max_sessions_per_source: The maximum number of sessions of one client address, 0 for no limit.
+     * @param[out] ticket: Receives the place of the session if it is admitted.
+     * @return Whether the session is admitted, or which cap it hit.
+     */
+    Verdict admit(const boost::asio::ip::address& source, std::size_t max_sessions, std::size_t max_sessions_per_source, Ticket& ticket);
+
+    /*
+     * Get the number of admitted sessions that have not released their place yet.
+     *
+     * @return The number of sessions.
+     */
+    std::size_t session_count() const;
+
+private:
+    struct Source_Hash {
+        std::size_t operator () (const Source& source) const;
+    };
+
+    struct Stripe {
+        std::mutex mutex;
+        std::unordered_map<Source, std::size_t, Source_Hash> sessions; // Addresses with at least one session.
+    };
+
+    static constexpr std::size_t STRIPE_COUNT = 64;
+
+    /*
+     * Gives the place of a ticket back.
+     *
+     * @param[in] ticket: The ticket.
+     */
+    void release(const Ticket& ticket);
+
+    /*
+     * Get the stripe counting an address.
+     *
+     * @param[in] source: The address.
+     * @return A reference to the stripe.
+     */
+    Stripe& stripe(const Source& source);
+
+    std::atomic<std::size_t> session_count_{ 0 };
+    std::array<Stripe, STRIPE_COUNT> stripes_;
+};
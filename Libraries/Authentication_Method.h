@@ -8,17 +8,24 @@
  */
 
 #pragma once
+#include <functional>
+#include <memory>
 #include <boost/asio.hpp>
 
+#include "Handshake_Buffer.h"
+
 struct Authentication_Result
 {
     const bool authenticated;
-    boost::asio::ip::tcp::socket socket;
     const int authentication_method;
     std::string error;
+    std::string username{}; // The authenticated user, empty for methods without user names.
 };
 
-class Authentication_Method
+// Completion handler invoked once the authentication exchange has finished.
+using Authentication_Handler = std::function<void(const Authentication_Result&)>;
+
+class Authentication_Method : public std::enable_shared_from_this<Authentication_Method>
 {
 public:
     Authentication_Method() {}
@@ -29,10 +36,12 @@ public:
     virtual ~Authentication_Method() {}
 
     /*
-     * Abstract method for authentication.
+     * Abstract method for asynchronous authentication. The method object keeps itself alive until
+     * the handler has been invoked; the socket and buffer must outlive the operation.
      *
      * @param[in] socket: The socket to authenticate.
-     * @return `Authentication_Result` struct indicating whether authentication is successful and associated details.
+     * @param[in] buffer: The handshake buffer. The sub-negotiation is parsed from it, whatever follows is left in it.
+     * @param[in] handler: The handler receiving the `Authentication_Result` of the exchange.
      */
-    virtual Authentication_Result authenticate(boost::asio::ip::tcp::socket socket) = 0;
+    virtual void async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer, Authentication_Handler handler) = 0;
 };
\ No newline at end of file
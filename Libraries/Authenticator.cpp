@@ -11,7 +11,7 @@
 
 Authenticator::Authenticator(const std::shared_ptr<Authentication_Method> method) : method(method) {}
 
-Authentication_Result Authenticator::authenticate(boost::asio::ip::tcp::socket socket)
+void Authenticator::async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer, Authentication_Handler handler)
 {
-    return method->authenticate(std::move(socket));
+    method->async_authenticate(socket, buffer, std::move(handler));
 }
@@ -26,10 +26,11 @@ public:
     Authenticator(const std::shared_ptr<Authentication_Method> method);
 
     /*
-     * Perform authentication using the provided method.
+     * Perform asynchronous authentication using the provided method.
      * 
      * @param[in] socket: The socket to authenticate.
-     * @return `Authentication_Result` struct indicating whether authentication is successful and associated details.
+     * @param[in] buffer: The handshake buffer holding what the client sent after its greeting.
+     * @param[in] handler: The handler receiving the `Authentication_Result` of the exchange.
      */
-    Authentication_Result authenticate(boost::asio::ip::tcp::socket socket);
+    void async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer, Authentication_Handler handler);
 };
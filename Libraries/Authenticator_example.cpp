@@ -4,46 +4,41 @@
 
 int main()
 {
-    const std::string path_to_file = "C:\\authentication_file.txt";
     const std::string username = "my_username";
     const std::string password = "my_password";
 
-    const std::shared_ptr<Authentication_Method> no_authentication = std::make_shared<No_Authentication>();
-    const std::shared_ptr<Authentication_Method> username_password = std::make_shared<Username_Password>(path_to_file, username, password);
-    const std::shared_ptr<Authentication_Method> gssapi = std::make_shared<GSSAPI>();
-
-    Authenticator auth_1(username_password);
-
-    if (auth_1.authenticate())
-    {
-        std::cout << "Client authenticated successfully." << std::endl;
-    }
-    else
-    {
-        std::cout << "Client authentication failed." << std::endl;
-    }
-
-    Authenticator auth_2(username_password);
-
-    if (auth_2.authenticate())
-    {
-        std::cout << "Client authenticated successfully." << std::endl;
-    }
-    else
-    {
-        std::cout << "Client authentication failed." << std::endl;
-    }
-
-    Authenticator auth_3(gssapi);
-
-    if (auth_3.authenticate())
+    try
     {
-        std::cout << "Client authenticated successfully." << std::endl;
+        boost::asio::io_context io_context;
+        boost::asio::ip::tcp::acceptor acceptor(io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 1080));
+        boost::asio::ip::tcp::socket socket(io_context);
+
+        // The client has to send its greeting (VER, NMETHODS, METHODS) before the method is chosen;
+        // here the username and password strategy is used unconditionally.
+        acceptor.accept(socket);
+
+        const std::shared_ptr<Authentication_Method> username_password = std::make_shared<Username_Password>(username, password);
+        Authenticator auth(username_password);
+        Handshake_Buffer buffer;
+
+        auth.async_authenticate(socket, buffer, [](const Authentication_Result& result)
+            {
+                if (result.authenticated)
+                {
+                    std::cout << "Client authenticated successfully." << std::endl;
+                }
+                else
+                {
+                    std::cout << "Client authentication failed. " << result.error << std::endl;
+                }
+            });
+
+        io_context.run();
     }
-    else
+    catch (std::exception& e)
     {
-        std::cout << "Client authentication failed." << std::endl;
+        std::cout << "ERROR: " << e.what() << std::endl;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,131 @@
+/*
+ * BandwidthShaper.cpp
+ * Purpose: Hierarchical token buckets limiting the bytes a tunnel relays per second: a bucket of its own,
+ *          one shared by the sessions of the same authenticated user and one shared by the sessions of the
+ *          same client IP address. A relay asks its chain for a budget before reading, so traffic over the
+ *          limit stays in the kernel and TCP flow control slows the sender down. The buckets are lock-free
+ *          and refilled lazily from one clock reading shared by every level of the chain, so no timer has to
+ *          walk them. Buckets shared by users and addresses live as long as a session uses them.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "BandwidthShaper.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    std::int64_t to_nanoseconds(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+}
+
+BandwidthShaper::Bucket::Bucket(std::uint64_t rate, std::uint64_t burst, std::chrono::steady_clock::time_point now)
+    : rate_((std::max)(rate, std::uint64_t(1))),
+    burst_(burst),
+    nanoseconds_per_byte_(1e9 / static_cast<double>(rate_)),
+    burst_time_(static_cast<std::int64_t>(static_cast<double>(burst_) * nanoseconds_per_byte_)),
+    empty_at_(to_nanoseconds(now) - burst_time_) {
+}
+
+std::int64_t BandwidthShaper::Bucket::available(std::chrono::steady_clock::time_point now) const {
+    const std::int64_t elapsed = to_nanoseconds(now) - empty_at_.load(std::memory_order_relaxed);
+    if (elapsed >= burst_time_) {
+        return static_cast<std::int64_t>(burst_);
+    }
+    return static_cast<std::int64_t>(static_cast<double>(elapsed) / nanoseconds_per_byte_);
+}
+
+std::chrono::nanoseconds BandwidthShaper::Bucket::refill_time(std::chrono::steady_clock::time_point now) const {
+    // One byte past the point where the debt is paid off.
+    const std::int64_t wait = empty_at_.load(std::memory_order_relaxed) - to_nanoseconds(now) + static_cast<std::int64_t>(nanoseconds_per_byte_) + 1;
+    return std::chrono::nanoseconds((std::max)(wait, std::int64_t(0)));
+}
+
+void BandwidthShaper::Bucket::consume(std::size_t bytes, std::chrono::steady_clock::time_point now) {
+    // Tokens accrued beyond the burst size are forfeited before the bytes are taken.
+    const std::int64_t full_at = to_nanoseconds(now) - burst_time_;
+    const std::int64_t cost = static_cast<std::int64_t>(static_cast<double>(bytes) * nanoseconds_per_byte_);
+    std::int64_t empty_at = empty_at_.load(std::memory_order_relaxed);
+    while (!empty_at_.compare_exchange_weak(empty_at, (std::max)(empty_at, full_at) + cost, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t BandwidthShaper::Bucket::rate() const {
+    return rate_;
+}
+
+std::uint64_t BandwidthShaper::Bucket::burst() const {
+    return burst_;
+}
+
+bool BandwidthShaper::Chain::limited() const {
+    return buckets_[0] || buckets_[1] || buckets_[2];
+}
+
+std::size_t BandwidthShaper::Chain::budget(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds& wait) const {
+    std::int64_t budget = std::numeric_limits<std::int64_t>::max();
+    wait = std::chrono::nanoseconds::zero();
+    for (const std::shared_ptr<Bucket>& bucket : buckets_) {
+        if (!bucket) {
+            continue;
+        }
+        const std::int64_t available = bucket->available(now);
+        if (available <= 0) {
+            wait = (std::max)(wait, bucket->refill_time(now));
+        }
+        budget = (std::min)(budget, available);
+    }
+    return budget > 0 ? static_cast<std::size_t>(budget) : 0;
+}
+
+void BandwidthShaper::Chain::consume(std::size_t bytes, std::chrono::steady_clock::time_point now) {
+    for (const std::shared_ptr<Bucket>& bucket : buckets_) {
+        if (bucket) {
+            bucket->consume(bytes, now);
+        }
+    }
+}
+
+BandwidthShaper::Chain BandwidthShaper::attach(const std::string& user, const std::string& source, const Policy& policy) {
+    Chain chain;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::uint64_t burst = policy.rate_limit_burst();
+    if (policy.session_rate_limit() != 0) {
+        chain.buckets_[0] = std::make_shared<Bucket>(policy.session_rate_limit(), burst, now);
+    }
+    if (policy.user_rate_limit() == 0 && policy.source_rate_limit() == 0) {
+        return chain;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (policy.user_rate_limit() != 0 && !user.empty()) {
+        chain.buckets_[1] = shared_bucket(users_, user, policy.user_rate_limit(), burst, now);
+    }
+    if (policy.source_rate_limit() != 0) {
+        chain.buckets_[2] = shared_bucket(sources_, source, policy.source_rate_limit(), burst, now);
+    }
+    return chain;
+}
+
+std::shared_ptr<BandwidthShaper::Bucket> BandwidthShaper::shared_bucket(Bucket_Map& map, const std::string& key, std::uint64_t rate, std::uint64_t burst, std::chrono::steady_clock::time_point now) {
+    std::weak_ptr<Bucket>& entry = map.buckets[key];
+    std::shared_ptr<Bucket> bucket = entry.lock();
+    if (bucket && bucket->rate() == rate && bucket->burst() == burst) {
+        return bucket;
+    }
+
+    // Sessions started before the limits changed keep the bucket they have.
+    bucket = std::make_shared<Bucket>(rate, burst, now);
+    entry = bucket;
+
+    if (map.buckets.size() >= map.purge_size) {
+        std::erase_if(map.buckets, [](const auto& shared) {
+            return shared.second.expired();
+        });
+        map.purge_size = (std::max)(map.buckets.size() * 2, std::size_t(1024));
+    }
+    return bucket;
+}
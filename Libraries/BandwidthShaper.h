@@ -0,0 +1,161 @@
+/*
+ * BandwidthShaper.h
+ * Purpose: Hierarchical token buckets limiting the bytes a tunnel relays per second: a bucket of its own,
+ *          one shared by the sessions of the same authenticated user and one shared by the sessions of the
+ *          same client IP address. A relay asks its chain for a budget before reading, so traffic over the
+ *          limit stays in the kernel and TCP flow control slows the sender down. The buckets are lock-free
+ *          and refilled lazily from one clock reading shared by every level of the chain, so no timer has to
+ *          walk them. Buckets shared by users and addresses live as long as a session uses them.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Policy.h"
+
+class BandwidthShaper {
+public:
+    // Byte budget refilled at a fixed rate up to the burst size. Safe to use from any thread.
+    class Bucket {
+    public:
+        /*
+         * Constructor for the Bucket class. The bucket starts full.
+         *
+         * @param[in] rate: The bytes added per second, at least one.
+         * @param[in] burst: The maximum number of bytes.
+         * @param[in] now: The current time.
+         */
+        Bucket(std::uint64_t rate, std::uint64_t burst, std::chrono::steady_clock::time_point now);
+
+        /*
+         * Get the bytes the bucket holds.
+         *
+         * @param[in] now: The current time.
+         * @return The number of bytes; negative while the bucket pays off bytes taken beyond its budget.
+         */
+        std::int64_t available(std::chrono::steady_clock::time_point now) const;
+
+        /*
+         * Get the time until the bucket holds bytes again.
+         *
+         * @param[in] now: The current time.
+         * @return The time, zero if it holds bytes already.
+         */
+        std::chrono::nanoseconds refill_time(std::chrono::steady_clock::time_point now) const;
+
+        /*
+         * Takes bytes from the bucket. The bytes are taken even if the bucket holds fewer, so a read that
+         * raced with another session on a shared bucket is paid off by the next ones.
+         *
+         * @param[in] bytes: The number of bytes relayed.
+         * @param[in] now: The current time.
+         */
+        void consume(std::size_t bytes, std::chrono::steady_clock::time_point now);
+
+        /*
+         * Get the rate of the bucket.
+         *
+         * @return The bytes added per second.
+         */
+        std::uint64_t rate() const;
+
+        /*
+         * Get the burst size of the bucket.
+         *
+         * @return The maximum number of bytes.
+         */
+        std::uint64_t burst() const;
+
+    private:
+        std::uint64_t rate_;
+        std::uint64_t burst_;
+        double nanoseconds_per_byte_;
+        std::int64_t burst_time_; // Time in nanoseconds it takes to fill the bucket.
+        std::atomic<std::int64_t> empty_at_; // Time in nanoseconds at which the bucket held no bytes.
+    };
+
+    // The buckets a session's traffic is charged to, from its own to the one of its client address.
+    class Chain {
+    public:
+        /*
+         * Get whether any level of the chain has a limit.
+         *
+         * @return True if the traffic is shaped.
+         */
+        bool limited() const;
+
+        /*
+         * Get the bytes every level of the chain allows to relay now.
+         *
+         * @param[in] now: The current time.
+         * @param[out] wait: Set to the time until every level holds bytes again when the budget is zero.
+         * @return The number of bytes, zero if a level is exhausted.
+         */
+        std::size_t budget(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds& wait) const;
+
+        /*
+         * Charges relayed bytes to every level of the chain.
+         *
+         * @param[in] bytes: The number of bytes relayed.
+         * @param[in] now: The current time.
+         */
+        void consume(std::size_t bytes, std::chrono::steady_clock::time_point now);
+
+    private:
+        friend class BandwidthShaper;
+
+        std::array<std::shared_ptr<Bucket>, 3> buckets_; // Session, user and client address; empty if unlimited.
+    };
+
+    BandwidthShaper() = default;
+
+    // Delete copy constructor to prevent unintended copying.
+    BandwidthShaper(const BandwidthShaper&) = delete;
+
+    // Delete assignment operator to prevent unintended copying.
+    BandwidthShaper& operator = (const BandwidthShaper&) = delete;
+
+    /*
+     * Builds the chain of a session from the limits of the policy. Safe to call from any thread.
+     *
+     * @param[in] user: The authenticated user name, empty if the session has none.
+     * @param[in] source: The client IP address.
+     * @param[in] policy: The policy of the session.
+     * @return The chain; unlimited if the policy sets no limits.
+     */
+    Chain attach(const std::string& user, const std::string& source, const Policy& policy);
+
+private:
+    // Shared buckets by key. Entries whose sessions have all ended are removed once the map has doubled.
+    struct Bucket_Map {
+        std::unordered_map<std::string, std::weak_ptr<Bucket>> buckets;
+        std::size_t purge_size = 1024;
+    };
+
+    /*
+     * Finds the bucket shared under a key, creating it if no session uses it or its limits changed.
+     *
+     * @param[in] map: The map of the shared buckets.
+     * @param[in] key: The user name or client address.
+     * @param[in] rate: The bytes added per second.
+     * @param[in] burst: The maximum number of bytes.
+     * @param[in] now: The current time.
+     * @return The bucket.
+     */
+    std::shared_ptr<Bucket> shared_bucket(Bucket_Map& map, const std::string& key, std::uint64_t rate, std::uint64_t burst, std::chrono::steady_clock::time_point now);
+
+    std::mutex mutex_;
+    Bucket_Map users_;
+    Bucket_Map sources_;
+};
@@ -0,0 +1,104 @@
+/*
+ * BufferPool.cpp
+ * Purpose: Per-thread pool of I/O buffers in power-of-two size classes.
+ *          Sessions check a buffer out only while data is actually in flight and return it as soon as the
+ *          write completes, so idle tunnels hold no buffer at all. Every thread caches released buffers in
+ *          its own free lists, which makes acquiring and releasing lock-free; the cache of each size class
+ *          is capped, and buffers beyond the cap are freed.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "BufferPool.h"
+
+#include <array>
+#include <bit>
+#include <vector>
+
+namespace {
+    const std::size_t MIN_CLASS_SHIFT = std::bit_width(BufferPool::MIN_BUFFER_SIZE) - 1;
+    const std::size_t CLASS_COUNT = std::bit_width(BufferPool::MAX_BUFFER_SIZE) - MIN_CLASS_SHIFT;
+
+    // Upper bound of memory each thread keeps cached per size class.
+    const std::size_t MAX_CACHED_BYTES_PER_CLASS = 1024 * 1024;
+
+    // Set once the calling thread's cache is gone; buffers released during thread exit are then freed directly.
+    thread_local bool cache_destroyed = false;
+
+    std::size_t class_size(std::size_t size_class) {
+        return std::size_t(1) << (size_class + MIN_CLASS_SHIFT);
+    }
+
+    // Released buffers of one thread, by size class. Freed when the thread exits.
+    struct Thread_Cache {
+        // The free lists are sized for their cap up front, so releasing never allocates.
+        Thread_Cache() {
+            for (std::size_t size_class = 0; size_class < CLASS_COUNT; ++size_class) {
+                free_lists[size_class].reserve(MAX_CACHED_BYTES_PER_CLASS / class_size(size_class));
+            }
+        }
+
+        Thread_Cache(const Thread_Cache&) = delete;
+        Thread_Cache& operator = (const Thread_Cache&) = delete;
+
+        ~Thread_Cache() {
+            cache_destroyed = true;
+            for (std::vector<char*>& free_list : free_lists) {
+                for (char* data : free_list) {
+                    delete[] data;
+                }
+            }
+        }
+
+        std::array<std::vector<char*>, CLASS_COUNT> free_lists;
+    };
+
+    thread_local Thread_Cache cache;
+
+    std::size_t size_class_of(std::size_t size) {
+        if (size <= BufferPool::MIN_BUFFER_SIZE) {
+            return 0;
+        }
+        return std::bit_width(size - 1) - MIN_CLASS_SHIFT;
+    }
+}
+
+BufferPool::Buffer BufferPool::acquire(std::size_t size) {
+    char* data = allocate(size);
+    return Buffer(data, size > MAX_BUFFER_SIZE ? size : class_size(size_class_of(size)));
+}
+
+char* BufferPool::allocate(std::size_t size) {
+    if (size > MAX_BUFFER_SIZE) {
+        return new char[size];
+    }
+
+    // Without the cache the buffer is still allocated at its class size, which Buffer::size() reports.
+    const std::size_t size_class = size_class_of(size);
+    if (cache_destroyed) {
+        return new char[class_size(size_class)];
+    }
+    std::vector<char*>& free_list = cache.free_lists[size_class];
+    if (!free_list.empty()) {
+        char* data = free_list.back();
+        free_list.pop_back();
+        return data;
+    }
+    return new char[class_size(size_class)];
+}
+
+void BufferPool::release(char* data, std::size_t size) noexcept {
+    if (size > MAX_BUFFER_SIZE || cache_destroyed) {
+        delete[] data;
+        return;
+    }
+
+    const std::size_t size_class = size_class_of(size);
+    std::vector<char*>& free_list = cache.free_lists[size_class];
+    if (free_list.size() * class_size(size_class) >= MAX_CACHED_BYTES_PER_CLASS) {
+        delete[] data;
+        return;
+    }
+    free_list.push_back(data);
+}
@@ -0,0 +1,147 @@
+/*
+ * BufferPool.h
+ * Purpose: Per-thread pool of I/O buffers in power-of-two size classes.
+ *          Sessions check a buffer out only while data is actually in flight and return it as soon as the
+ *          write completes, so idle tunnels hold no buffer at all. Every thread caches released buffers in
+ *          its own free lists, which makes acquiring and releasing lock-free; the cache of each size class
+ *          is capped, and buffers beyond the cap are freed. The same free lists back an allocator for
+ *          short-lived objects such as the completion handlers of pending operations.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <cstddef>
+#include <utility>
+
+class BufferPool {
+public:
+    // Smallest and largest size class; larger requests are allocated and freed directly.
+    static constexpr std::size_t MIN_BUFFER_SIZE = 512;
+    static constexpr std::size_t MAX_BUFFER_SIZE = 256 * 1024;
+
+    // A buffer checked out of the pool. Returns itself to the pool of the releasing thread.
+    class Buffer {
+    public:
+        Buffer() = default;
+
+        Buffer(Buffer&& other) noexcept
+            : data_(std::exchange(other.data_, nullptr)),
+            size_(std::exchange(other.size_, 0)) {
+        }
+
+        // Delete copy constructor to prevent releasing the buffer twice.
+        Buffer(const Buffer&) = delete;
+
+        /*
+         * Destructor. Returns the buffer to the pool.
+         */
+        ~Buffer() {
+            reset();
+        }
+
+        Buffer& operator = (Buffer&& other) noexcept {
+            if (this != &other) {
+                reset();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+            }
+            return *this;
+        }
+
+        // Delete assignment operator to prevent releasing the buffer twice.
+        Buffer& operator = (const Buffer&) = delete;
+
+        /*
+         * Returns the buffer to the pool, leaving this object empty.
+         */
+        void reset() {
+            if (data_ != nullptr) {
+                BufferPool::release(data_, size_);
+                data_ = nullptr;
+                size_ = 0;
+            }
+        }
+
+        char* data() const {
+            return data_;
+        }
+
+        // The usable size, which is the requested size rounded up to its size class.
+        std::size_t size() const {
+            return size_;
+        }
+
+        explicit operator bool() const {
+            return data_ != nullptr;
+        }
+
+    private:
+        friend class BufferPool;
+
+        Buffer(char* data, std::size_t size)
+            : data_(data),
+            size_(size) {
+        }
+
+        char* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    // Standard allocator drawing from the calling thread's pool; memory may be freed on any thread.
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        Allocator() noexcept = default;
+
+        template <typename U>
+        Allocator(const Allocator<U>&) noexcept {
+        }
+
+        T* allocate(std::size_t count) {
+            return reinterpret_cast<T*>(BufferPool::allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T* data, std::size_t count) noexcept {
+            BufferPool::release(reinterpret_cast<char*>(data), count * sizeof(T));
+        }
+
+        template <typename U>
+        bool operator == (const Allocator<U>&) const noexcept {
+            return true;
+        }
+
+        template <typename U>
+        bool operator != (const Allocator<U>&) const noexcept {
+            return false;
+        }
+    };
+
+    /*
+     * Checks a buffer out of the calling thread's pool, allocating a new one if the pool is empty.
+     *
+     * @param[in] size: The minimum size of the buffer.
+     * @return The buffer.
+     */
+    static Buffer acquire(std::size_t size);
+
+private:
+    /*
+     * Takes memory out of the calling thread's pool, allocating it if the pool is empty.
+     *
+     * @param[in] size: The minimum size of the memory.
+     * @return The memory, at least as large as its size class.
+     */
+    static char* allocate(std::size_t size);
+
+    /*
+     * Returns a buffer to the calling thread's pool, or frees it if that size class is full.
+     *
+     * @param[in] data: The buffer.
+     * @param[in] size: The size of the buffer, or the size it was requested with.
+     */
+    static void release(char* data, std::size_t size) noexcept;
+};
@@ -0,0 +1,215 @@
+/*
+ * ConfigWatcher.cpp
+ * Purpose: Watches the configuration file and recompiles the policy whenever it changes.
+ *          On Linux the file's directory is watched with inotify, elsewhere the modification time is polled.
+ *          The file is parsed and compiled on the watcher thread; the new policy is handed over only if
+ *          that succeeded, so a broken edit never replaces a working policy. Reload counts, failures and
+ *          durations are recorded in Metrics.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "ConfigWatcher.h"
+
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "Metrics.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Source reported in the IP column of log entries written by the watcher.
+    const std::string LOG_SOURCE = "config";
+
+    // How often the modification time is checked when inotify is unavailable.
+    const std::chrono::milliseconds POLL_INTERVAL(1000);
+
+    // Editors often write a file in several steps; changes are applied once the file has been quiet this long.
+    const std::chrono::milliseconds SETTLE_DELAY(100);
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& path, Reload_Handler handler, const std::shared_ptr<Logger> logger)
+    : path_(path),
+    handler_(std::move(handler)),
+    logger_(logger),
+    stopping_(false),
+    stop_fd_(-1) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+void ConfigWatcher::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+
+    stopping_ = false;
+#ifdef __linux__
+    stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+
+    thread_ = std::thread([this] {
+        if (!watch_notifications()) {
+            watch_polling();
+        }
+    });
+}
+
+void ConfigWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_condition_.notify_all();
+
+#ifdef __linux__
+    if (stop_fd_ >= 0) {
+        const std::uint64_t value = 1;
+        [[maybe_unused]] const ssize_t written = write(stop_fd_, &value, sizeof(value));
+    }
+#endif
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+#ifdef __linux__
+    if (stop_fd_ >= 0) {
+        close(stop_fd_);
+        stop_fd_ = -1;
+    }
+#endif
+}
+
+bool ConfigWatcher::reload() {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<const Policy> policy;
+    try {
+        ProxyConfiguration config;
+        config.loadConfigFromIni(path_);
+        policy = std::make_shared<const Policy>(config);
+    }
+    catch (const std::exception& e) {
+        Metrics::instance().add(Metrics::Counter::Config_Reload_Failures);
+        log(spdlog::level::err, "Configuration reload failed, keeping the previous policy. " + std::string(e.what()));
+        return false;
+    }
+
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    handler_(std::move(policy));
+
+    Metrics& metrics = Metrics::instance();
+    metrics.add(Metrics::Counter::Config_Reloads);
+    metrics.set(Metrics::Counter::Config_Reload_Last_Duration_Us, static_cast<std::uint64_t>(duration.count()));
+    metrics.add(Metrics::Counter::Config_Reload_Total_Duration_Us, static_cast<std::uint64_t>(duration.count()));
+
+    log(spdlog::level::info, "Configuration reloaded in " + std::to_string(duration.count()) + " us.");
+    return true;
+}
+
+bool ConfigWatcher::watch_notifications() {
+#ifdef __linux__
+    if (stop_fd_ < 0) {
+        return false;
+    }
+
+    const std::filesystem::path path(path_);
+    const std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    const std::string filename = path.filename().string();
+
+    const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        return false;
+    }
+
+    // The directory is watched rather than the file, because editors often replace the file by renaming a new one over it.
+    if (inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(inotify_fd);
+        return false;
+    }
+
+    // Returns true if any of the pending events concerns the configuration file.
+    const auto read_events = [inotify_fd, &filename] {
+        alignas(inotify_event) char buffer[4096];
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* position = buffer; position < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+                if (event->len > 0 && filename == event->name) {
+                    changed = true;
+                }
+                position += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+    };
+
+    pollfd descriptors[2] = { { inotify_fd, POLLIN, 0 }, { stop_fd_, POLLIN, 0 } };
+    bool pending = false;
+    while (true) {
+        // Once a change was seen, wait until the file settles before reading it.
+        const int timeout = pending ? static_cast<int>(SETTLE_DELAY.count()) : -1;
+        const int ready = poll(descriptors, 2, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (descriptors[1].revents != 0) {
+            break;
+        }
+        if (ready > 0 && descriptors[0].revents != 0) {
+            pending = read_events() || pending;
+            continue;
+        }
+        if (ready == 0 && pending) {
+            pending = false;
+            reload();
+        }
+    }
+
+    close(inotify_fd);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ConfigWatcher::watch_polling() {
+    std::error_code error;
+    std::filesystem::file_time_type last_write_time = std::filesystem::last_write_time(path_, error);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_condition_.wait_for(lock, POLL_INTERVAL, [this] { return stopping_; })) {
+        const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path_, error);
+        if (error || write_time == last_write_time) {
+            continue;
+        }
+        last_write_time = write_time;
+
+        lock.unlock();
+        reload();
+        lock.lock();
+    }
+}
+
+void ConfigWatcher::log(const spdlog::level::level_enum log_level, const std::string& message) {
+    (log_level == spdlog::level::err ? std::cerr : std::cout) << message << std::endl;
+    if (logger_) {
+        logger_->add_to_queue(log_level, LOG_SOURCE, message);
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * ConfigWatcher.h
+ * Purpose: Watches the configuration file and recompiles the policy whenever it changes.
+ *          On Linux the file's directory is watched with inotify, elsewhere the modification time is polled.
+ *          The file is parsed and compiled on the watcher thread; the new policy is handed over only if
+ *          that succeeded, so a broken edit never replaces a working policy. Reload counts, failures and
+ *          durations are recorded in Metrics.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Logger.h"
+#include "Policy.h"
+
+class ConfigWatcher {
+public:
+    using Reload_Handler = std::function<void(std::shared_ptr<const Policy>)>;
+
+    /*
+     * Constructor for the ConfigWatcher class.
+     *
+     * @param[in] path: The path of the configuration file.
+     * @param[in] handler: The handler receiving each successfully compiled policy. Runs on the watcher thread.
+     * @param[in] logger: A shared_ptr to a Logger instance for logging.
+     */
+    ConfigWatcher(const std::string& path, Reload_Handler handler, const std::shared_ptr<Logger> logger);
+
+    // Delete copy constructor to prevent unintended copying.
+    ConfigWatcher(const ConfigWatcher&) = delete;
+
+    /*
+     * Destructor. Stops the watcher thread.
+     */
+    ~ConfigWatcher();
+
+    // Delete assignment operator to prevent unintended copying.
+    ConfigWatcher& operator = (const ConfigWatcher&) = delete;
+
+    /*
+     * Starts watching the configuration file on a background thread.
+     */
+    void start();
+
+    /*
+     * Stops watching and waits for the watcher thread to finish. Safe to call more than once.
+     */
+    void stop();
+
+    /*
+     * Parses the configuration file, compiles it and passes the new policy to the handler.
+     *
+     * @return True if the configuration was reloaded, false if it could not be parsed.
+     */
+    bool reload();
+
+private:
+    /*
+     * Waits for changes with inotify until stopped.
+     *
+     * @return False if inotify is unavailable and the caller has to fall back to polling.
+     */
+    bool watch_notifications();
+
+    /*
+     * Polls the modification time of the file until stopped.
+     */
+    void watch_polling();
+
+    /*
+     * Logs a message to the console and the logger.
+     *
+     * @param[in] log_level: The log level of the message.
+     * @param[in] message: The log message.
+     */
+    void log(const spdlog::level::level_enum log_level, const std::string& message);
+
+    std::string path_;
+    Reload_Handler handler_;
+    std::shared_ptr<Logger> logger_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable stop_condition_;
+    bool stopping_;
+    int stop_fd_; // eventfd waking the inotify loop on stop(), or -1.
+};
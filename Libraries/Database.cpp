@@ -9,6 +9,56 @@
 
 #include "Database.h"
 
+#include <algorithm>
+
+#include "Metrics.h"
+
+namespace
+{
+    // Maximum number of entries the writer thread takes from the ring at once.
+    const std::size_t POP_SIZE = 256;
+
+    // How long a write waits for a transaction of another process on the same file, such as the proxy handing
+    // its listening sockets over, before it fails.
+    const int BUSY_TIMEOUT_MS = 5000;
+
+    // How long the writer waits after a failed transaction, so a database that keeps failing is not retried in a busy loop.
+    const std::chrono::milliseconds FAILURE_PAUSE(100);
+
+    const char* const INSERT_QUERY = "INSERT INTO logs (timestamp, log_level, IP, message) VALUES (?, ?, ?, ?)";
+}
+
+void Database::open()
+{
+    int rc = sqlite3_open_v2(path_to_db.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+    if (rc)
+    {
+        throw std::runtime_error("Unable to open database.");
+    }
+
+    // WAL lets readers run next to the writer, and with synchronous=NORMAL a commit no longer waits for fsync.
+    execute("PRAGMA journal_mode=WAL");
+    execute("PRAGMA synchronous=NORMAL");
+    sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+
+    create_table();
+
+    rc = sqlite3_prepare_v2(db, INSERT_QUERY, -1, &insert_statement, nullptr);
+    if (rc != SQLITE_OK)
+    {
+        throw std::runtime_error("Unable to prepare a statement.");
+    }
+}
+
+void Database::execute(const char* query)
+{
+    const int rc = sqlite3_exec(db, query, nullptr, nullptr, nullptr);
+    if (rc != SQLITE_OK)
+    {
+        throw std::runtime_error(std::string("Unable to execute query: ") + query);
+    }
+}
+
 void Database::create_table()
 {
     const std::string query = "CREATE TABLE IF NOT EXISTS logs ("
@@ -27,21 +77,49 @@ void Database::create_table()
 
 void Database::work()
 {
-    while (true)
+    std::vector<Database_Entry> batch;
+    batch.reserve(POP_SIZE);
+
+    // wait() returns false only once the ring is closed and fully drained.
+    while (queue.wait())
     {
-        std::unique_lock<std::mutex> lock(mutex);
-        condition.wait(lock, [this] { return stop || !queue.empty(); });
+        // The batch is committed once it holds batch_size rows or its oldest row has waited flush_interval. It is
+        // collected before the lock is taken, so queries only wait for the transaction itself.
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + flush_interval;
+        while (batch.size() < batch_size)
+        {
+            if (queue.pop_batch(batch, (std::min)(POP_SIZE, batch_size - batch.size())) == 0 && !queue.wait_until(deadline))
+            {
+                break;
+            }
+        }
 
-        if (stop && queue.empty())
+        bool failed = false;
         {
-            lock.unlock();
-            return;
+            std::lock_guard<std::mutex> lock(db_mutex);
+            try
+            {
+                execute("BEGIN");
+                for (const Database_Entry& entry : batch)
+                {
+                    insert(entry.timestamp, entry.log_level, entry.IP, entry.message);
+                }
+                execute("COMMIT");
+            }
+            catch (const std::exception&)
+            {
+                // The rows of the transaction are lost, but the writer keeps running for the entries that follow.
+                sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+                Metrics::instance().add(Metrics::Counter::Database_Entries_Failed, batch.size());
+                failed = true;
+            }
         }
+        batch.clear();
 
-        const Database_Entry& entry = queue.front();
-        insert(entry.timestamp, entry.log_level, entry.IP, entry.message);
-        queue.pop();
-        lock.unlock();
+        if (failed)
+        {
+            std::this_thread::sleep_for(FAILURE_PAUSE);
+        }
     }
 }
 
@@ -78,6 +156,8 @@ std::string Database::get_log_level(const spdlog::level::level_enum log_level)
 
 std::string Database::get_data(const std::string& query, const std::string& param)
 {
+    std::lock_guard<std::mutex> lock(db_mutex);
+
     std::stringstream result("");
     sqlite3_stmt* stmt;
     const int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
@@ -113,79 +193,54 @@ std::string Database::get_data(const std::string& query, const std::string& para
 
 void Database::insert(const std::string& timestamp, const std::string& log_level, const std::string& IP, const std::string& message)
 {
-
-    const std::string query = "INSERT INTO logs (timestamp, log_level, IP, message) VALUES (?, ?, ?, ?)";
-
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK)
-    {
-        throw std::runtime_error("Unable to prepare a statement.");
-    }
-    sqlite3_bind_text(stmt, 1, timestamp.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, log_level.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, IP.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, message.c_str(), -1, SQLITE_TRANSIENT);
+    // The strings outlive the step, so SQLite does not need its own copies.
+    sqlite3_stmt* stmt = insert_statement;
+    int rc = sqlite3_bind_text(stmt, 1, timestamp.c_str(), static_cast<int>(timestamp.size()), SQLITE_STATIC);
+    rc |= sqlite3_bind_text(stmt, 2, log_level.c_str(), static_cast<int>(log_level.size()), SQLITE_STATIC);
+    rc |= sqlite3_bind_text(stmt, 3, IP.c_str(), static_cast<int>(IP.size()), SQLITE_STATIC);
+    rc |= sqlite3_bind_text(stmt, 4, message.c_str(), static_cast<int>(message.size()), SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        sqlite3_finalize(stmt);
+        sqlite3_reset(stmt);
         throw std::runtime_error("Unable to bind parameters.");
     }
 
     rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
     if (rc != SQLITE_DONE)
     {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Unable to execute statement.");
     }
-
-    sqlite3_finalize(stmt);
 }
 
-Database::Database(const std::size_t thread_count) : path_to_db("C:\\Proxy_server\\database.db"), thread_count(thread_count), stop(false)
+Database::Database(const std::size_t /*thread_count*/, const std::size_t queue_capacity, const std::size_t batch_size, const std::chrono::milliseconds flush_interval)
+    : db(nullptr), insert_statement(nullptr), path_to_db("C:\\Proxy_server\\database.db"), queue(queue_capacity),
+    batch_size((std::max)(batch_size, std::size_t(1))), flush_interval(flush_interval)
 {
-    const int rc = sqlite3_open_v2(path_to_db.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
-    if (rc)
-    {
-        throw std::runtime_error("Unable to open database.");
-    }
-
-    create_table();
+    open();
 
-    for (std::size_t i = 0; i < thread_count; ++i)
-    {
-        threads.emplace_back([this] { work(); });
-    }
+    threads.emplace_back([this] { work(); });
 }
 
-Database::Database(const std::size_t thread_count, const std::string& path_to_db) : path_to_db(path_to_db), thread_count(thread_count), stop(false)
+Database::Database(const std::size_t /*thread_count*/, const std::string& path_to_db, const std::size_t queue_capacity, const std::size_t batch_size, const std::chrono::milliseconds flush_interval)
+    : db(nullptr), insert_statement(nullptr), path_to_db(path_to_db), queue(queue_capacity),
+    batch_size((std::max)(batch_size, std::size_t(1))), flush_interval(flush_interval)
 {
-    const int rc = sqlite3_open_v2(path_to_db.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
-    if (rc)
-    {
-        throw std::runtime_error("Unable to open database.");
-    }
-
-    create_table();
+    open();
 
-    for (std::size_t i = 0; i < thread_count; ++i)
-    {
-        threads.emplace_back([this] { work(); });
-    }
+    threads.emplace_back([this] { work(); });
 }
 
 Database::~Database()
 {
-    std::unique_lock<std::mutex> lock(mutex);
-    stop = true;
-    condition.notify_all();
-    lock.unlock();
+    queue.close();
 
     for (std::thread& thread : threads)
     {
         thread.join();
     }
 
+    sqlite3_finalize(insert_statement);
     sqlite3_close(db);
 }
 
@@ -194,9 +249,10 @@ void Database::add_to_queue(const spdlog::level::level_enum log_level, const std
     const std::string timestamp = get_timestamp();
     const std::string log_level_string = get_log_level(log_level);
 
-    std::unique_lock<std::mutex> lock(mutex);
-    queue.push({ timestamp, log_level_string, IP, message });
-    condition.notify_one();
+    if (!queue.try_push({ timestamp, log_level_string, IP, message }))
+    {
+        Metrics::instance().add(Metrics::Counter::Database_Entries_Dropped);
+    }
 }
 
 std::string Database::query_all()
@@ -240,6 +296,8 @@ std::string Database::query_message(const std::string& message)
 
 void Database::clear_database()
 {
+    std::lock_guard<std::mutex> lock(db_mutex);
+
     const std::string query = "DROP TABLE IF EXISTS logs";
     const int rc = sqlite3_exec(db, query.c_str(), nullptr, nullptr, nullptr);
     if (rc != SQLITE_OK)
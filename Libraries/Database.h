@@ -2,21 +2,27 @@
  * Database.h
  * Purpose: Database class for initializing and managing database operations for logging purposes.
  *          Provides a multi-threaded mechanism for inserting and querying log entries in an SQLite database.
+ *          Entries are handed to the writer thread through a bounded lock-free ring, so sessions never
+ *          wait for the database; when the ring is full the entry is dropped and counted.
+ *          The writer keeps the INSERT statement prepared and commits entries in batched transactions
+ *          on a WAL journal, flushing once a batch is full or its oldest entry has waited long enough.
  *
  * @author Szymon Sikaa
  * @version 1.1 30/08/2023
  */
 
 #pragma once
+#include <chrono>
+#include <mutex>
 #include <sstream>
-#include <queue>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <vector>
 
 #include <sqlite3.h>
 #include <spdlog/spdlog.h>
 
+#include "MpscRing.h"
+
 struct Database_Entry
 {
     std::string timestamp;
@@ -27,18 +33,43 @@ struct Database_Entry
 
 class Database
 {
+public:
+    // Default number of entries the ring can hold.
+    static constexpr std::size_t DEFAULT_QUEUE_CAPACITY = 65536;
+
+    // Default maximum number of entries committed in one transaction.
+    static constexpr std::size_t DEFAULT_BATCH_SIZE = 4096;
+
+    // Default maximum time an entry waits for its transaction to be committed.
+    static constexpr std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL{ 100 };
+
 private:
     // Variables used to handle database.
     sqlite3* db;
+    sqlite3_stmt* insert_statement;
     std::string path_to_db;
+    std::mutex db_mutex; // Serializes the writer's transactions with queries issued by other threads.
 
     // Variables used to handle worker threads.
-    std::size_t thread_count;
     std::vector <std::thread> threads;
-    std::queue<Database_Entry> queue;
-    std::mutex mutex;
-    std::condition_variable condition;
-    bool stop;
+    MpscRing<Database_Entry> queue;
+    std::size_t batch_size;
+    std::chrono::milliseconds flush_interval;
+
+    /*
+     * Opens the database, switches it to WAL mode, creates the table and prepares the INSERT statement.
+     *
+     * @throws std::runtime_error if any of these steps fails.
+     */
+    void open();
+
+    /*
+     * Executes a statement that returns no rows.
+     *
+     * @param[in] query: The SQL statement to execute.
+     * @throws std::runtime_error if unable to execute the statement.
+     */
+    void execute(const char* query);
 
     /*
      * Creates the required table in the database if it doesn't exist.
@@ -47,7 +78,8 @@ private:
 
     /*
      * Worker thread function to process database entries from the queue and insert them into the database.
-     * This function is used by multiple worker threads to process entries concurrently.
+     * The writer thread is the only consumer of the ring and drains it in batches, each written in a single transaction.
+     * A batch whose transaction fails is rolled back and counted as lost; the writer carries on with the next one.
      */
     void work();
 
@@ -78,13 +110,13 @@ private:
     std::string get_data(const std::string& query, const std::string& param = "");
 
     /*
-     * Inserts a new log entry into the database.
+     * Inserts a new log entry into the database using the prepared INSERT statement.
      *
      * @param[in] timestamp: The timestamp of the log entry.
      * @param[in] log_level: The log level of the entry.
      * @param[in] IP: The client's IP address.
      * @param[in] message: The log message to be written.
-     * @throws std::runtime_error if unable to prepare a statement, bind parameters, or execute the statement.
+     * @throws std::runtime_error if unable to bind parameters or execute the statement.
      */
     void insert(const std::string& timestamp, const std::string& log_level, const std::string& IP, const std::string& message);
 
@@ -96,20 +128,28 @@ public:
      * Constructor that creates a Database instance with a specified number of worker threads.
      * Initializes the SQLite database and creates the required table.
      *
-     * @param[in] thread_count: The number of worker threads to handle database entries.
+     * @param[in] thread_count: Kept for compatibility. A single writer thread is used, as SQLite serializes writes anyway.
+     * @param[in] queue_capacity: The number of entries the ring can hold.
+     * @param[in] batch_size: The maximum number of entries committed in one transaction.
+     * @param[in] flush_interval: The maximum time an entry waits for its transaction to be committed.
      * @throws std::runtime_error if unable to open database or create the table.
      */
-    explicit Database(const std::size_t thread_count);
+    explicit Database(const std::size_t thread_count, const std::size_t queue_capacity = DEFAULT_QUEUE_CAPACITY,
+        const std::size_t batch_size = DEFAULT_BATCH_SIZE, const std::chrono::milliseconds flush_interval = DEFAULT_FLUSH_INTERVAL);
 
     /*
      * Constructor that creates a Database instance with a specified number of worker threads and a custom database path.
      * Initializes the SQLite database at the specified path and creates the required table.
      *
-     * @param[in] thread_count: The number of worker threads to handle database entries.
+     * @param[in] thread_count: Kept for compatibility. A single writer thread is used, as SQLite serializes writes anyway.
      * @param[in] path_to_db: The path to the SQLite database file.
+     * @param[in] queue_capacity: The number of entries the ring can hold.
+     * @param[in] batch_size: The maximum number of entries committed in one transaction.
+     * @param[in] flush_interval: The maximum time an entry waits for its transaction to be committed.
      * @throws std::runtime_error if unable to open database or create the table.
      */
-    explicit Database(const std::size_t thread_count, const std::string& path_to_db);
+    explicit Database(const std::size_t thread_count, const std::string& path_to_db, const std::size_t queue_capacity = DEFAULT_QUEUE_CAPACITY,
+        const std::size_t batch_size = DEFAULT_BATCH_SIZE, const std::chrono::milliseconds flush_interval = DEFAULT_FLUSH_INTERVAL);
 
     // Delete copy constructor to prevent unintended copying.
     Database(const Database&) = delete;
@@ -124,6 +164,7 @@ public:
 
     /*
      * Add a log entry to the queue with the specified log level, client IP address, and message.
+     * Never blocks: if the ring is full, the entry is dropped and counted in Metrics.
      *
      * @param[in] log_level: The log level of the entry.
      * @param[in] IP: The client's IP address.
@@ -0,0 +1,169 @@
+/*
+ * DnsCache.cpp
+ * Purpose: Process-wide asynchronous host name resolver with a shared cache.
+ *          Lookups run on a small pool of resolver threads, so reactor threads never block on DNS.
+ *          Answers are cached for a limited time (failures for a shorter one), concurrent lookups
+ *          of the same name are coalesced into one query, and frequently used entries are refreshed
+ *          in the background shortly before they expire.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "DnsCache.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    // Number of threads running blocking getaddrinfo() calls.
+    const std::size_t RESOLVER_THREAD_COUNT = 4;
+
+    // An entry hit at least this many times during its lifetime is refreshed before it expires.
+    const std::size_t REFRESH_MIN_HITS = 8;
+
+    // Popular entries are refreshed once less than 1/REFRESH_AHEAD_DIVISOR of their TTL is left.
+    const int REFRESH_AHEAD_DIVISOR = 5;
+
+    std::string normalize(const std::string& hostname)
+    {
+        std::string key(hostname);
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (!key.empty() && key.back() == '.')
+        {
+            key.pop_back();
+        }
+        return key;
+    }
+}
+
+DnsCache::DnsCache(std::chrono::seconds ttl, std::chrono::seconds negative_ttl, std::size_t max_entries)
+    : ttl_(ttl), negative_ttl_(negative_ttl), max_entries_(max_entries), resolver_threads_(RESOLVER_THREAD_COUNT) {}
+
+DnsCache::~DnsCache()
+{
+    resolver_threads_.join();
+}
+
+void DnsCache::async_resolve(const std::string& hostname, const boost::asio::ip::tcp::socket::executor_type& executor, Resolve_Handler handler)
+{
+    const std::string key = normalize(hostname);
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Entry& entry = entries_[key];
+
+    if (entry.resolved && now < entry.expires)
+    {
+        ++entry.hits;
+
+        // Refresh popular names in the background so they never expire while in use.
+        if (!entry.error && !entry.lookup_pending && entry.hits >= REFRESH_MIN_HITS && entry.expires - now <= ttl_ / REFRESH_AHEAD_DIVISOR)
+        {
+            entry.lookup_pending = true;
+            start_lookup(key);
+        }
+
+        const boost::system::error_code error = entry.error;
+        const std::shared_ptr<const Addresses> addresses = entry.addresses;
+        lock.unlock();
+
+        boost::asio::post(executor, [handler = std::move(handler), error, addresses] { handler(error, addresses); });
+        return;
+    }
+
+    // Join the lookup already in flight for this name, or start a new one.
+    entry.waiters.push_back({ executor, std::move(handler) });
+    if (!entry.lookup_pending)
+    {
+        entry.lookup_pending = true;
+        start_lookup(key);
+    }
+}
+
+void DnsCache::start_lookup(const std::string& hostname)
+{
+    boost::asio::post(resolver_threads_, [this, hostname] {
+        boost::asio::ip::tcp::resolver resolver(resolver_threads_.get_executor());
+        boost::system::error_code error;
+        const boost::asio::ip::tcp::resolver::results_type results = resolver.resolve(hostname, "", error);
+        complete_lookup(hostname, error, results);
+    });
+}
+
+void DnsCache::complete_lookup(const std::string& hostname, boost::system::error_code error, const boost::asio::ip::tcp::resolver::results_type& results)
+{
+    auto addresses = std::make_shared<Addresses>();
+    if (!error)
+    {
+        for (const auto& result : results)
+        {
+            const boost::asio::ip::address address = result.endpoint().address();
+            if (std::find(addresses->begin(), addresses->end(), address) == addresses->end())
+            {
+                addresses->push_back(address);
+            }
+        }
+        if (addresses->empty())
+        {
+            error = boost::asio::error::host_not_found;
+        }
+    }
+
+    std::vector<Waiter> waiters;
+    std::shared_ptr<const Addresses> cached_addresses;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[hostname];
+        entry.lookup_pending = false;
+        waiters.swap(entry.waiters);
+
+        // A failed background refresh keeps serving the previous answer until it expires.
+        const bool keep_previous = error && entry.resolved && !entry.error && waiters.empty();
+        if (!keep_previous)
+        {
+            entry.addresses = std::move(addresses);
+            entry.error = error;
+            entry.expires = std::chrono::steady_clock::now() + (error ? negative_ttl_ : ttl_);
+            entry.hits = 0;
+            entry.resolved = true;
+        }
+
+        error = entry.error;
+        cached_addresses = entry.addresses;
+
+        if (entries_.size() > max_entries_)
+        {
+            evict();
+        }
+    }
+
+    for (Waiter& waiter : waiters)
+    {
+        boost::asio::post(waiter.executor, [handler = std::move(waiter.handler), error, cached_addresses] {
+            handler(error, cached_addresses);
+        });
+    }
+}
+
+void DnsCache::evict()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::erase_if(entries_, [now](const auto& item) {
+        const Entry& entry = item.second;
+        return entry.resolved && !entry.lookup_pending && entry.waiters.empty() && entry.expires <= now;
+    });
+
+    for (auto it = entries_.begin(); it != entries_.end() && entries_.size() > max_entries_;)
+    {
+        if (!it->second.lookup_pending && it->second.waiters.empty())
+        {
+            it = entries_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
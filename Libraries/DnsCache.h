@@ -0,0 +1,102 @@
+/*
+ * DnsCache.h
+ * Purpose: Process-wide asynchronous host name resolver with a shared cache.
+ *          Lookups run on a small pool of resolver threads, so reactor threads never block on DNS.
+ *          Answers are cached for a limited time (failures for a shorter one), concurrent lookups
+ *          of the same name are coalesced into one query, and frequently used entries are refreshed
+ *          in the background shortly before they expire.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/asio.hpp>
+
+class DnsCache {
+public:
+    using Addresses = std::vector<boost::asio::ip::address>;
+    using Resolve_Handler = std::function<void(const boost::system::error_code&, const std::shared_ptr<const Addresses>&)>;
+
+    /*
+     * Constructor for the DnsCache class.
+     *
+     * @param[in] ttl: How long resolved names are cached for.
+     * @param[in] negative_ttl: How long failed lookups are cached for.
+     * @param[in] max_entries: The maximum number of cached names.
+     */
+    DnsCache(std::chrono::seconds ttl, std::chrono::seconds negative_ttl, std::size_t max_entries);
+
+    // Delete copy constructor to prevent unintended copying.
+    DnsCache(const DnsCache&) = delete;
+
+    /*
+     * Destructor. Waits for the resolver threads to finish.
+     */
+    ~DnsCache();
+
+    // Delete assignment operator to prevent unintended copying.
+    DnsCache& operator = (const DnsCache&) = delete;
+
+    /*
+     * Resolves a host name, answering from the cache when possible.
+     * The handler is always invoked through the given executor, never from inside this call.
+     *
+     * @param[in] hostname: The host name to resolve.
+     * @param[in] executor: The executor the handler is run on.
+     * @param[in] handler: The handler receiving the error code and the resolved addresses.
+     */
+    void async_resolve(const std::string& hostname, const boost::asio::ip::tcp::socket::executor_type& executor, Resolve_Handler handler);
+
+private:
+    // A session waiting for a lookup in progress.
+    struct Waiter {
+        boost::asio::ip::tcp::socket::executor_type executor;
+        Resolve_Handler handler;
+    };
+
+    struct Entry {
+        std::shared_ptr<const Addresses> addresses;
+        boost::system::error_code error;
+        std::chrono::steady_clock::time_point expires;
+        std::size_t hits = 0;
+        bool resolved = false;
+        bool lookup_pending = false;
+        std::vector<Waiter> waiters;
+    };
+
+    /*
+     * Starts a lookup of the host name on the resolver threads.
+     *
+     * @param[in] hostname: The host name to resolve.
+     */
+    void start_lookup(const std::string& hostname);
+
+    /*
+     * Stores the outcome of a lookup and completes the sessions waiting for it.
+     *
+     * @param[in] hostname: The resolved host name.
+     * @param[in] error: The error code of the lookup.
+     * @param[in] results: The resolved endpoints.
+     */
+    void complete_lookup(const std::string& hostname, boost::system::error_code error, const boost::asio::ip::tcp::resolver::results_type& results);
+
+    /*
+     * Removes expired entries, and arbitrary ones if the cache is still full. Must be called with the mutex held.
+     */
+    void evict();
+
+    std::chrono::seconds ttl_;
+    std::chrono::seconds negative_ttl_;
+    std::size_t max_entries_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    boost::asio::thread_pool resolver_threads_;
+};
@@ -0,0 +1,250 @@
+/*
+ * DomainPolicy.cpp
+ * Purpose: Host name rules of the destination access list. Rules are written as
+ *          `example.com` (exact name), `*.example.com` (any subdomain) or `~regex` (regular expression).
+ *          Exact and wildcard rules are compiled into a trie of reversed labels that is matched in a single
+ *          right-to-left pass over the name; regular expressions are only tried when no trie rule matches.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "DomainPolicy.h"
+
+#include <cstring>
+
+namespace {
+    const std::string_view WILDCARD_PREFIX = "*.";
+    const char REGEX_PREFIX = '~';
+
+    // Longest label that can be stored in an edge.
+    const std::size_t MAX_LABEL_SIZE = UINT8_MAX;
+
+    // Initial number of slots in the edge table; it is kept at most half full.
+    const std::size_t INITIAL_EDGE_SLOTS = 64;
+
+    char to_lower(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    std::string to_lower(std::string_view text) {
+        std::string result(text);
+        for (char& c : result) {
+            c = to_lower(c);
+        }
+        return result;
+    }
+
+    std::uint64_t hash_label(std::uint32_t parent, std::string_view label) {
+        // FNV-1a over the parent index and the lowercased label.
+        std::uint64_t hash = 14695981039346656037ull;
+        for (int i = 0; i < 4; ++i) {
+            hash = (hash ^ ((parent >> (i * 8)) & 0xFF)) * 1099511628211ull;
+        }
+        for (char c : label) {
+            hash = (hash ^ static_cast<unsigned char>(to_lower(c))) * 1099511628211ull;
+        }
+        return hash | 1;
+    }
+
+    // Compares a label of the looked up name with a lowercased stored one.
+    bool equal_labels(std::string_view label, std::string_view stored) {
+        if (label.size() != stored.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < label.size(); ++i) {
+            if (to_lower(label[i]) != stored[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string_view strip_trailing_dot(std::string_view name) {
+        if (!name.empty() && name.back() == '.') {
+            name.remove_suffix(1);
+        }
+        return name;
+    }
+}
+
+DomainPolicy::DomainPolicy()
+    : nodes_(1),
+    edges_(INITIAL_EDGE_SLOTS),
+    edge_count_(0),
+    rule_count_(0) {
+}
+
+bool DomainPolicy::add_rule(const std::string& rule, Acl_Action action) {
+    if (rule.empty()) {
+        return false;
+    }
+
+    if (rule[0] == REGEX_PREFIX) {
+        try {
+            regex_rules_.push_back({ std::regex(rule.substr(1), std::regex::ECMAScript | std::regex::icase | std::regex::optimize), action });
+        }
+        catch (const std::regex_error&) {
+            return false;
+        }
+        return true;
+    }
+
+    std::string_view name = rule;
+    const bool wildcard = name.starts_with(WILDCARD_PREFIX);
+    if (wildcard) {
+        name.remove_prefix(WILDCARD_PREFIX.size());
+    }
+    name = strip_trailing_dot(name);
+    if (name.empty() || name.find('*') != std::string_view::npos) {
+        return false;
+    }
+
+    // Walk the labels right to left, creating the missing nodes.
+    std::uint32_t node = ROOT;
+    std::size_t end = name.size();
+    while (true) {
+        const std::size_t dot = name.rfind('.', end - 1);
+        const std::size_t begin = dot == std::string_view::npos ? 0 : dot + 1;
+        const std::string_view label = name.substr(begin, end - begin);
+        if (label.empty() || label.size() > MAX_LABEL_SIZE) {
+            return false;
+        }
+
+        const std::uint32_t child = find_child(node, label);
+        node = child != NONE ? child : add_child(node, label);
+
+        if (dot == std::string_view::npos) {
+            break;
+        }
+        end = dot;
+    }
+
+    merge(wildcard ? nodes_[node].wildcard : nodes_[node].exact, action);
+    ++rule_count_;
+    return true;
+}
+
+Acl_Action DomainPolicy::match(std::string_view hostname) const {
+    const std::string_view name = strip_trailing_dot(hostname);
+
+    Acl_Action wildcard = Acl_Action::None;
+    std::uint32_t node = ROOT;
+    bool complete = !name.empty();
+    std::size_t end = name.size();
+    while (complete) {
+        const std::size_t dot = end == 0 ? std::string_view::npos : name.rfind('.', end - 1);
+        const std::size_t begin = dot == std::string_view::npos ? 0 : dot + 1;
+
+        // At least one more label follows, so a wildcard rule on this node covers the name.
+        if (nodes_[node].wildcard != Acl_Action::None) {
+            wildcard = nodes_[node].wildcard;
+        }
+
+        node = find_child(node, name.substr(begin, end - begin));
+        if (node == NONE) {
+            complete = false;
+            break;
+        }
+
+        if (dot == std::string_view::npos) {
+            break;
+        }
+        end = dot;
+    }
+
+    if (complete && nodes_[node].exact != Acl_Action::None) {
+        return nodes_[node].exact;
+    }
+    if (wildcard != Acl_Action::None || regex_rules_.empty()) {
+        return wildcard;
+    }
+
+    // Slow path: regular expressions must match the whole name.
+    const std::string lowered = to_lower(name);
+    Acl_Action result = Acl_Action::None;
+    for (const Regex_Rule& rule : regex_rules_) {
+        if (std::regex_match(lowered, rule.pattern)) {
+            merge(result, rule.action);
+        }
+    }
+    return result;
+}
+
+std::size_t DomainPolicy::size() const {
+    return rule_count_;
+}
+
+void DomainPolicy::merge(Acl_Action& slot, Acl_Action action) {
+    if (action == Acl_Action::Deny || slot == Acl_Action::None) {
+        slot = action;
+    }
+}
+
+std::uint32_t DomainPolicy::find_child(std::uint32_t parent, std::string_view label) const {
+    if (label.size() > MAX_LABEL_SIZE) {
+        return NONE;
+    }
+
+    const std::uint64_t hash = hash_label(parent, label);
+    const std::size_t mask = edges_.size() - 1;
+    for (std::size_t slot = static_cast<std::size_t>(hash) & mask; edges_[slot].hash != 0; slot = (slot + 1) & mask) {
+        const Edge& edge = edges_[slot];
+        if (edge.hash == hash && edge.parent == parent && equal_labels(label, label_of(edge))) {
+            return edge.child;
+        }
+    }
+    return NONE;
+}
+
+std::uint32_t DomainPolicy::add_child(std::uint32_t parent, std::string_view label) {
+    if ((edge_count_ + 1) * 2 > edges_.size()) {
+        std::vector<Edge> old_edges(edges_.size() * 2);
+        old_edges.swap(edges_);
+        for (const Edge& edge : old_edges) {
+            if (edge.hash != 0) {
+                place(edge);
+            }
+        }
+    }
+
+    Edge edge;
+    edge.hash = hash_label(parent, label);
+    edge.parent = parent;
+    edge.child = static_cast<std::uint32_t>(nodes_.size());
+    edge.length = static_cast<std::uint8_t>(label.size());
+
+    const std::string lowered = to_lower(label);
+    if (lowered.size() <= INLINE_LABEL_SIZE) {
+        std::memcpy(edge.label, lowered.data(), lowered.size());
+    }
+    else {
+        const std::uint32_t offset = static_cast<std::uint32_t>(long_labels_.size());
+        std::memcpy(edge.label, &offset, sizeof(offset));
+        long_labels_ += lowered;
+    }
+
+    place(edge);
+    ++edge_count_;
+    nodes_.emplace_back();
+    return edge.child;
+}
+
+void DomainPolicy::place(const Edge& edge) {
+    const std::size_t mask = edges_.size() - 1;
+    std::size_t slot = static_cast<std::size_t>(edge.hash) & mask;
+    while (edges_[slot].hash != 0) {
+        slot = (slot + 1) & mask;
+    }
+    edges_[slot] = edge;
+}
+
+std::string_view DomainPolicy::label_of(const Edge& edge) const {
+    if (edge.length <= INLINE_LABEL_SIZE) {
+        return std::string_view(edge.label, edge.length);
+    }
+
+    std::uint32_t offset = 0;
+    std::memcpy(&offset, edge.label, sizeof(offset));
+    return std::string_view(long_labels_).substr(offset, edge.length);
+}
@@ -0,0 +1,123 @@
+/*
+ * DomainPolicy.h
+ * Purpose: Host name rules of the destination access list. Rules are written as
+ *          `example.com` (exact name), `*.example.com` (any subdomain) or `~regex` (regular expression).
+ *          Exact and wildcard rules are compiled into a trie of reversed labels that is matched in a single
+ *          right-to-left pass over the name; regular expressions are only tried when no trie rule matches.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PrefixTrie.h"
+
+class DomainPolicy {
+public:
+    DomainPolicy();
+
+    /*
+     * Adds a host name rule. When the same rule is added twice, Deny takes precedence over Allow.
+     *
+     * @param[in] rule: The exact name, `*.`-prefixed suffix or `~`-prefixed regular expression.
+     * @param[in] action: The action attached to the rule.
+     * @return True if the rule was added, false if it is malformed.
+     */
+    bool add_rule(const std::string& rule, Acl_Action action);
+
+    /*
+     * Finds the rule for a host name, ignoring case and a trailing dot. An exact rule takes precedence over
+     * wildcard rules, a longer wildcard suffix over a shorter one, and trie rules over regular expressions.
+     *
+     * @param[in] hostname: The host name to match.
+     * @return The action of the most specific matching rule, or `Acl_Action::None` if no rule matches.
+     */
+    Acl_Action match(std::string_view hostname) const;
+
+    /*
+     * Get the number of exact and wildcard rules.
+     *
+     * @return The number of rules compiled into the trie.
+     */
+    std::size_t size() const;
+
+private:
+    static constexpr std::uint32_t ROOT = 0;
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    // Labels up to this length are stored inside the edge, so a lookup touches one cache line per label.
+    static constexpr std::size_t INLINE_LABEL_SIZE = 15;
+
+    struct Node {
+        Acl_Action exact = Acl_Action::None;    // Rule for the name ending at this node.
+        Acl_Action wildcard = Acl_Action::None; // Rule for every name below this node.
+    };
+
+    // Edges are keyed by parent node and lowercased label, so the whole trie shares one open-addressing table.
+    struct Edge {
+        std::uint64_t hash = 0;                 // Zero marks an empty slot.
+        std::uint32_t parent = 0;
+        std::uint32_t child = 0;
+        std::uint8_t length = 0;
+        char label[INLINE_LABEL_SIZE] = {};     // The label, or its offset in long_labels_ if it does not fit.
+    };
+
+    struct Regex_Rule {
+        std::regex pattern;
+        Acl_Action action;
+    };
+
+    /*
+     * Merges an action into a rule slot, Deny taking precedence over Allow.
+     *
+     * @param[in,out] slot: The rule slot.
+     * @param[in] action: The action to merge.
+     */
+    static void merge(Acl_Action& slot, Acl_Action action);
+
+    /*
+     * Finds the child of a node reached through a label, ignoring case.
+     *
+     * @param[in] parent: The parent node.
+     * @param[in] label: The label.
+     * @return The child node, or NONE if there is no such edge.
+     */
+    std::uint32_t find_child(std::uint32_t parent, std::string_view label) const;
+
+    /*
+     * Adds an edge to a new child node.
+     *
+     * @param[in] parent: The parent node.
+     * @param[in] label: The label.
+     * @return The new child node.
+     */
+    std::uint32_t add_child(std::uint32_t parent, std::string_view label);
+
+    /*
+     * Places an edge into the table without checking for duplicates or growing it.
+     *
+     * @param[in] edge: The edge to place.
+     */
+    void place(const Edge& edge);
+
+    /*
+     * Get the label stored in an edge.
+     *
+     * @param[in] edge: The edge.
+     * @return The lowercased label.
+     */
+    std::string_view label_of(const Edge& edge) const;
+
+    std::vector<Node> nodes_;
+    std::vector<Edge> edges_;
+    std::size_t edge_count_;
+    std::string long_labels_;
+    std::vector<Regex_Rule> regex_rules_;
+    std::size_t rule_count_;
+};
@@ -0,0 +1,98 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./DomainPolicy.h"
+
+// Builds a host name of two to four labels under one of a few top-level domains.
+std::string make_name(std::mt19937& random, std::size_t n)
+{
+    static const char* top_level_domains[] = { "com", "net", "org", "io", "example" };
+    std::string name = "host" + std::to_string(n) + ".zone" + std::to_string(random() % 50000);
+    if (random() % 2 == 0)
+    {
+        name = "cdn" + std::to_string(random() % 100) + "." + name;
+    }
+    return name + "." + top_level_domains[random() % 5];
+}
+
+int main()
+{
+    const std::size_t rule_count = 1000000;
+    const std::size_t query_count = 2000000;
+
+    std::mt19937 random(42);
+    std::vector<std::string> names;
+    names.reserve(rule_count);
+
+    DomainPolicy policy;
+    const auto build_start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rule_count; i++)
+    {
+        names.push_back(make_name(random, i));
+
+        // Two thirds exact rules, one third wildcard rules, alternating between allow and deny.
+        const Acl_Action action = i % 2 == 0 ? Acl_Action::Allow : Acl_Action::Deny;
+        policy.add_rule(i % 3 == 0 ? "*." + names.back() : names.back(), action);
+    }
+    policy.add_rule("~^ads[0-9]+\\..*", Acl_Action::Deny);
+    const auto build_end = std::chrono::steady_clock::now();
+
+    // Half of the queries hit a rule (mixed case, some below a wildcard), half miss and fall through to the regex.
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (std::size_t i = 0; i < query_count; i++)
+    {
+        const std::string& name = names[random() % rule_count];
+        switch (i % 4)
+        {
+        case 0:
+            queries.push_back(name);
+            break;
+        case 1:
+            queries.push_back("WWW." + name);
+            break;
+        case 2:
+            queries.push_back("miss" + std::to_string(i) + ".unknown.com");
+            break;
+        default:
+            queries.push_back("miss." + std::to_string(i) + ".zone1.net");
+            break;
+        }
+    }
+
+    std::size_t matched = 0;
+    const auto match_start = std::chrono::steady_clock::now();
+    for (const std::string& query : queries)
+    {
+        matched += policy.match(query) != Acl_Action::None;
+    }
+    const auto match_end = std::chrono::steady_clock::now();
+
+    // Same queries without the regex slow path.
+    DomainPolicy trie_only;
+    for (std::size_t i = 0; i < rule_count; i++)
+    {
+        trie_only.add_rule(i % 3 == 0 ? "*." + names[i] : names[i], i % 2 == 0 ? Acl_Action::Allow : Acl_Action::Deny);
+    }
+    const auto trie_start = std::chrono::steady_clock::now();
+    for (const std::string& query : queries)
+    {
+        matched += trie_only.match(query) != Acl_Action::None;
+    }
+    const auto trie_end = std::chrono::steady_clock::now();
+
+    const auto per_query = [query_count](auto start, auto end) {
+        return std::chrono::duration<double, std::nano>(end - start).count() / query_count;
+    };
+
+    std::cout << "Rules: " << policy.size() << " (built in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(build_end - build_start).count() << " ms)" << std::endl;
+    std::cout << "Match with regex slow path: " << per_query(match_start, match_end) << " ns/query" << std::endl;
+    std::cout << "Match trie only: " << per_query(trie_start, trie_end) << " ns/query" << std::endl;
+    std::cout << "Matched: " << matched << std::endl;
+
+    return 0;
+}
@@ -11,11 +11,18 @@
 
 GSSAPI::GSSAPI() {}
 
-Authentication_Result GSSAPI::authenticate(boost::asio::ip::tcp::socket socket)
+void GSSAPI::async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer&, Authentication_Handler handler)
 {
-    const std::array<unsigned char, 2> response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0x01) };
-    boost::asio::write(socket, boost::asio::buffer(response));
+    response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0x01) };
+    boost::asio::async_write(socket, boost::asio::buffer(response),
+        [self = shared_from_this(), handler = std::move(handler)](const boost::system::error_code& error, std::size_t)
+        {
+            if (error)
+            {
+                handler({ false, 1, "Error while sending method selection: " + error.message() });
+                return;
+            }
 
-    Authentication_Result result = { false, std::move(socket), 1, "" };
-    return result;
+            handler({ false, 1, "" });
+        });
 }
\ No newline at end of file
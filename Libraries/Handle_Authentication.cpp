@@ -10,64 +10,91 @@
 
 #include "Handle_Authentication.h"
 
-Handle_Authentication::Handle_Authentication(const ProxyConfiguration& config, boost::asio::ip::tcp::socket socket, const int buffer_size) : proxy_config(config), socket(std::move(socket)), buffer_size(buffer_size)
+Handle_Authentication::Handle_Authentication(const std::shared_ptr<const Policy> policy, boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer) : policy(policy), socket(socket), buffer(buffer) {}
+
+void Handle_Authentication::async_handle_authentication(Authentication_Handler handler)
 {
-    data = new char[buffer_size];
+    this->handler = std::move(handler);
+
+    // The greeting starts with the SOCKS version and the number of offered methods.
+    buffer.async_fill(socket, 2,
+        [self = shared_from_this(), this](const boost::system::error_code& error)
+        {
+            if (error)
+            {
+                this->handler({ false, -1, "Error while reading SOCKS request: " + error.message() });
+                return;
+            }
+
+            const int version = buffer.data()[0];
+            if (version != 5)
+            {
+                this->handler({ false, -1, "Unsupported SOCKS version: " + std::to_string(version) + "." });
+                return;
+            }
+
+            read_methods(buffer.data()[1]);
+        });
 }
 
-Handle_Authentication::~Handle_Authentication()
+void Handle_Authentication::read_methods(const int nmethods)
 {
-    delete[] data;
+    buffer.async_fill(socket, 2 + nmethods,
+        [self = shared_from_this(), this, nmethods](const boost::system::error_code& error)
+        {
+            if (error)
+            {
+                this->handler({ false, -1, "Error while reading authentication methods: " + error.message() });
+                return;
+            }
+
+            select_method(nmethods);
+        });
 }
 
-Authentication_Result Handle_Authentication::handle_authentication()
+void Handle_Authentication::select_method(const int nmethods)
 {
-    boost::system::error_code error;
-    std::size_t bytes_transferred = boost::asio::read(socket, boost::asio::buffer(data, 1), error);
-
-    if (!error)
+    std::shared_ptr<Authentication_Method> auth_method;
+    for (int i = 0; i < nmethods && !auth_method; i++)
     {
-        const int nmethods = static_cast<unsigned char>(data[0]);
-        bytes_transferred = boost::asio::read(socket, boost::asio::buffer(data + 1, nmethods), error);
+        auth_method = create_method(buffer.data()[i + 2]);
+    }
 
-        if (!error)
-        {
-            for (int i = 0; i < nmethods; i++)
-            {
-                const int method = static_cast<unsigned char>(data[i + 1]);
-                if ((method == 0x00 && proxy_config.getAuthenticationMethod() == 0) || (method == 0x00 && proxy_config.getAuthenticationMethod() == -1))
-                {
-                    const std::shared_ptr<Authentication_Method> auth_method = std::make_shared<No_Authentication>();
-                    Authenticator auth(auth_method);
+    // Whatever follows the greeting belongs to the sub-negotiation or the request.
+    buffer.consume(2 + nmethods);
 
-                    return auth.authenticate(std::move(socket));
-                }
-                else if ((method == 0x01 && proxy_config.getAuthenticationMethod() == 1) || (method == 0x01 && proxy_config.getAuthenticationMethod() == -1))
-                {
-                    const std::shared_ptr<Authentication_Method> auth_method = std::make_shared<GSSAPI>();
-                    Authenticator auth(auth_method);
+    if (auth_method)
+    {
+        Authenticator auth(auth_method);
+        auth.async_authenticate(socket, buffer, std::move(handler));
+        return;
+    }
 
-                    return auth.authenticate(std::move(socket));
-                }
-                else if ((method == 0x02 && proxy_config.getAuthenticationMethod() == 2) || (method == 0x02 && proxy_config.getAuthenticationMethod() == -1))
-                {
-                    const std::shared_ptr<Authentication_Method> auth_method = std::make_shared<Username_Password>(proxy_config.getUsername(), proxy_config.getPassword());
-                    Authenticator auth(auth_method);
+    // None of the offered methods is acceptable (RFC 1928: X'FF' NO ACCEPTABLE METHODS).
+    response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0xFF) };
+    boost::asio::async_write(socket, boost::asio::buffer(response),
+        [self = shared_from_this(), this](const boost::system::error_code&, std::size_t)
+        {
+            this->handler({ false, -1, "Unsupported authentication method." });
+        });
+}
 
-                    return auth.authenticate(std::move(socket));
-                }
-                else
-                {
-                    Authentication_Result result = { false, std::move(socket), -1, "Unsupported authentication method." };
-                    return result;
-                }
-            }
-        }
+std::shared_ptr<Authentication_Method> Handle_Authentication::create_method(const int method) const
+{
+    const int configured_method = policy->authentication_method();
 
-        Authentication_Result result = { false, std::move(socket), -1, "Error while reading authentication methods: " + error.message() };
-        return result;
+    if ((method == 0x00 && configured_method == 0) || (method == 0x00 && configured_method == -1))
+    {
+        return std::make_shared<No_Authentication>();
+    }
+    else if ((method == 0x01 && configured_method == 1) || (method == 0x01 && configured_method == -1))
+    {
+        return std::make_shared<GSSAPI>();
+    }
+    else if ((method == 0x02 && configured_method == 2) || (method == 0x02 && configured_method == -1))
+    {
+        return std::make_shared<Username_Password>(policy->username(), policy->password());
     }
 
-    Authentication_Result result = { false, std::move(socket), -1, "Error while reading SOCKS request: " + error.message() };
-    return result;
+    return nullptr;
 }
\ No newline at end of file
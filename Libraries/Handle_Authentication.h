@@ -10,35 +10,54 @@
 
 #pragma once
 #include "Authenticator.h"
-#include "ProxyConfiguration.h"
+#include "Policy.h"
 
-class Handle_Authentication
+class Handle_Authentication : public std::enable_shared_from_this<Handle_Authentication>
 {
 private:
-    ProxyConfiguration proxy_config;
-    boost::asio::ip::tcp::socket socket;
-    int buffer_size;
-    char* data;
+    std::shared_ptr<const Policy> policy;
+    boost::asio::ip::tcp::socket& socket;
+    Handshake_Buffer& buffer;
+    std::array<unsigned char, 2> response;
+    Authentication_Handler handler;
 
-public:
     /*
-     * Constructor to initialize the Handle_Authentication instance.
+     * Waits until the list of authentication methods offered by the client has been received.
      *
-     * @param[in] config: The proxy configuration.
-     * @param[in] socket: The socket to authenticate.
-     * @param[in] buffer_size: The size of the buffer to be used for reading data from the socket.
+     * @param[in] nmethods: The number of offered methods.
      */
-    Handle_Authentication(const ProxyConfiguration& config, boost::asio::ip::tcp::socket socket, const int buffer_size);
+    void read_methods(const int nmethods);
 
     /*
-     * Destructor to free the memory allocated for the buffer.
+     * Selects the first offered method allowed by the configuration and runs its sub-negotiation.
+     *
+     * @param[in] nmethods: The number of offered methods.
+     */
+    void select_method(const int nmethods);
+
+    /*
+     * Creates the authentication method for a method code offered by the client.
+     *
+     * @param[in] method: The SOCKS5 method code.
+     * @return The authentication method, or nullptr if the code is not allowed by the configuration.
+     */
+    std::shared_ptr<Authentication_Method> create_method(const int method) const;
+
+public:
+    /*
+     * Constructor to initialize the Handle_Authentication instance.
+     *
+     * @param[in] policy: The policy snapshot of the session.
+     * @param[in] socket: The socket to authenticate. It must outlive the authentication exchange.
+     * @param[in] buffer: The handshake buffer the greeting and sub-negotiation are parsed from. It must outlive the authentication exchange.
      */
-    ~Handle_Authentication();
+    Handle_Authentication(const std::shared_ptr<const Policy> policy, boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer);
 
     /*
-     * Handle authentication for incoming connections.
+     * Handle authentication for incoming connections asynchronously: parses the client greeting,
+     * selects a method and runs its sub-negotiation. Bytes the client sent beyond them are left in the buffer. The instance keeps itself alive until the handler is invoked.
      *
-     * @return `Authentication_Result` struct indicating whether authentication is successful and associated details.
+     * @param[in] handler: The handler receiving the `Authentication_Result` of the exchange.
      */
-    Authentication_Result handle_authentication();
+    void async_handle_authentication(Authentication_Handler handler);
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+ * Handshake_Buffer.cpp
+ * Purpose: Receive buffer shared by every step of the SOCKS handshake: the greeting, the authentication
+ *          sub-negotiation and the request are all parsed from it. Each read takes whatever the client has
+ *          sent, so a client that does not wait for the replies has its next messages buffered already,
+ *          and payload sent right after the request is kept until it can be forwarded to the target.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "Handshake_Buffer.h"
+
+#include <cstring>
+
+const unsigned char* Handshake_Buffer::data() const
+{
+    return reinterpret_cast<const unsigned char*>(storage.data()) + begin;
+}
+
+std::size_t Handshake_Buffer::size() const
+{
+    return end - begin;
+}
+
+void Handshake_Buffer::consume(std::size_t count)
+{
+    begin += count;
+    if (begin == end)
+    {
+        begin = 0;
+        end = 0;
+    }
+}
+
+boost::asio::mutable_buffer Handshake_Buffer::prepare()
+{
+    if (!storage)
+    {
+        storage = BufferPool::acquire(CAPACITY);
+    }
+    if (begin > 0)
+    {
+        std::memmove(storage.data(), storage.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    return boost::asio::buffer(storage.data() + end, storage.size() - end);
+}
+
+void Handshake_Buffer::commit(std::size_t count)
+{
+    end += count;
+}
+
+void Handshake_Buffer::reserve(std::size_t capacity)
+{
+    if (storage.size() >= capacity)
+    {
+        return;
+    }
+
+    BufferPool::Buffer larger = BufferPool::acquire(capacity);
+    if (size() > 0)
+    {
+        std::memcpy(larger.data(), storage.data() + begin, size());
+    }
+    end = size();
+    begin = 0;
+    storage = std::move(larger);
+}
+
+void Handshake_Buffer::async_fill(boost::asio::ip::tcp::socket& socket, std::size_t count, Fill_Handler handler)
+{
+    if (size() >= count)
+    {
+        handler({});
+        return;
+    }
+    if (count > CAPACITY)
+    {
+        handler(boost::asio::error::message_size);
+        return;
+    }
+
+    socket.async_read_some(prepare(),
+        [this, &socket, count, handler = std::move(handler)](const boost::system::error_code& error, std::size_t bytes_transferred) mutable
+        {
+            if (error)
+            {
+                handler(error);
+                return;
+            }
+
+            commit(bytes_transferred);
+            async_fill(socket, count, std::move(handler));
+        });
+}
+
+void Handshake_Buffer::release()
+{
+    storage.reset();
+    begin = 0;
+    end = 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Handshake_Buffer.h
+ * Purpose: Receive buffer shared by every step of the SOCKS handshake: the greeting, the authentication
+ *          sub-negotiation and the request are all parsed from it. Each read takes whatever the client has
+ *          sent, so a client that does not wait for the replies has its next messages buffered already,
+ *          and payload sent right after the request is kept until it can be forwarded to the target.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <functional>
+#include <boost/asio.hpp>
+
+#include "BufferPool.h"
+
+class Handshake_Buffer
+{
+public:
+    // Completion handler of async_fill.
+    using Fill_Handler = std::function<void(const boost::system::error_code&)>;
+
+    // Default size of the buffer. The longest handshake message, a username and password sub-negotiation, takes 513 bytes.
+    static constexpr std::size_t CAPACITY = 4096;
+
+    /*
+     * Get the received bytes that have not been consumed yet.
+     *
+     * @return The first unconsumed byte.
+     */
+    const unsigned char* data() const;
+
+    /*
+     * Get the number of received bytes that have not been consumed yet.
+     *
+     * @return The number of bytes.
+     */
+    std::size_t size() const;
+
+    /*
+     * Marks bytes at the front of the buffer as parsed.
+     *
+     * @param[in] count: The number of bytes, at most size().
+     */
+    void consume(std::size_t count);
+
+    /*
+     * Get the free space behind the received bytes, moving them to the front of the buffer first.
+     * The buffer is checked out of the pool on first use.
+     *
+     * @return The space a read may fill.
+     */
+    boost::asio::mutable_buffer prepare();
+
+    /*
+     * Appends bytes read into the space returned by prepare().
+     *
+     * @param[in] count: The number of bytes read.
+     */
+    void commit(std::size_t count);
+
+    /*
+     * Grows the buffer, keeping the bytes it holds.
+     *
+     * @param[in] capacity: The minimum size of the buffer.
+     */
+    void reserve(std::size_t capacity);
+
+    /*
+     * Makes sure at least `count` unconsumed bytes are buffered, reading from the socket only if they have not
+     * arrived yet. The handler is invoked directly if they have. The buffer and socket must outlive the operation.
+     *
+     * @param[in] socket: The socket to read from.
+     * @param[in] count: The number of bytes needed, at most CAPACITY.
+     * @param[in] handler: The handler receiving the error code of the read.
+     */
+    void async_fill(boost::asio::ip::tcp::socket& socket, std::size_t count, Fill_Handler handler);
+
+    /*
+     * Returns the buffer to the pool and drops whatever it still holds.
+     */
+    void release();
+
+private:
+    BufferPool::Buffer storage;
+    std::size_t begin = 0; // First unconsumed byte.
+    std::size_t end = 0; // One past the last received byte.
+};
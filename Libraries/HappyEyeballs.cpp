@@ -0,0 +1,135 @@
+/*
+ * HappyEyeballs.cpp
+ * Purpose: Connects to the first reachable endpoint of a target by racing staggered attempts (RFC 8305).
+ *          The endpoints are reordered so that address families alternate, and a new attempt starts
+ *          whenever the previous one failed or has not succeeded within the attempt delay. The first
+ *          connection established wins and the other attempts are cancelled, so an unreachable address
+ *          costs at most the attempt delay instead of a full TCP connect timeout.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "HappyEyeballs.h"
+
+namespace {
+    // Alternates the address families, starting with the family the resolver preferred (RFC 8305, section 4).
+    std::vector<boost::asio::ip::tcp::endpoint> interleave(const std::vector<boost::asio::ip::tcp::endpoint>& endpoints) {
+        std::vector<boost::asio::ip::tcp::endpoint> preferred;
+        std::vector<boost::asio::ip::tcp::endpoint> other;
+        for (const boost::asio::ip::tcp::endpoint& endpoint : endpoints) {
+            (endpoint.protocol() == endpoints.front().protocol() ? preferred : other).push_back(endpoint);
+        }
+
+        std::vector<boost::asio::ip::tcp::endpoint> interleaved;
+        interleaved.reserve(endpoints.size());
+        for (std::size_t i = 0; i < preferred.size() || i < other.size(); ++i) {
+            if (i < preferred.size()) {
+                interleaved.push_back(preferred[i]);
+            }
+            if (i < other.size()) {
+                interleaved.push_back(other[i]);
+            }
+        }
+        return interleaved;
+    }
+}
+
+HappyEyeballs::HappyEyeballs(const boost::asio::ip::tcp::socket::executor_type& executor, const std::vector<boost::asio::ip::tcp::endpoint>& endpoints, std::chrono::milliseconds attempt_delay)
+    : executor_(executor),
+    endpoints_(endpoints.empty() ? endpoints : interleave(endpoints)),
+    attempt_delay_(attempt_delay),
+    attempt_timer_(executor),
+    pending_(0),
+    finished_(false),
+    last_error_(boost::asio::error::host_not_found) {
+    attempts_.reserve(endpoints_.size());
+}
+
+void HappyEyeballs::async_connect(Connect_Handler handler) {
+    handler_ = std::move(handler);
+
+    if (endpoints_.empty()) {
+        boost::asio::post(executor_, [self = shared_from_this()] {
+            self->finish(self->last_error_, boost::asio::ip::tcp::socket(self->executor_));
+        });
+        return;
+    }
+
+    start_attempt();
+}
+
+void HappyEyeballs::cancel() {
+    if (finished_) {
+        return;
+    }
+
+    // Closing the attempts completes them with `operation_aborted`; the last one to complete ends the race.
+    last_error_ = boost::asio::error::operation_aborted;
+    endpoints_.resize(attempts_.size());
+    attempt_timer_.cancel();
+    for (boost::asio::ip::tcp::socket& attempt : attempts_) {
+        boost::system::error_code ignored;
+        attempt.close(ignored);
+    }
+}
+
+void HappyEyeballs::start_attempt() {
+    const std::size_t index = attempts_.size();
+    attempts_.emplace_back(executor_);
+    ++pending_;
+
+    // The socket is opened by the connect, which reports a failure to open through the handler.
+    attempts_[index].async_connect(endpoints_[index],
+        [self = shared_from_this(), index](const boost::system::error_code& error) {
+            self->handle_attempt(index, error);
+        });
+
+    if (attempts_.size() < endpoints_.size()) {
+        attempt_timer_.expires_after(attempt_delay_);
+        attempt_timer_.async_wait(
+            [self = shared_from_this()](const boost::system::error_code& error) {
+                // A wait superseded by an earlier start has its expiry moved into the future.
+                if (!error && !self->finished_ && self->attempt_timer_.expiry() <= std::chrono::steady_clock::now()
+                    && self->attempts_.size() < self->endpoints_.size()) {
+                    self->start_attempt();
+                }
+            });
+    }
+}
+
+void HappyEyeballs::handle_attempt(std::size_t index, const boost::system::error_code& error) {
+    --pending_;
+    if (finished_) {
+        return;
+    }
+
+    if (!error && attempts_[index].is_open()) {
+        finish(error, std::move(attempts_[index]));
+        return;
+    }
+
+    if (last_error_ != boost::asio::error::operation_aborted) {
+        last_error_ = error;
+    }
+
+    // A failed attempt does not wait for the delay: the next address is tried right away.
+    if (attempts_.size() < endpoints_.size()) {
+        start_attempt();
+    }
+    else if (pending_ == 0) {
+        finish(last_error_, boost::asio::ip::tcp::socket(executor_));
+    }
+}
+
+void HappyEyeballs::finish(const boost::system::error_code& error, boost::asio::ip::tcp::socket socket) {
+    finished_ = true;
+    attempt_timer_.cancel();
+    for (boost::asio::ip::tcp::socket& attempt : attempts_) {
+        boost::system::error_code ignored;
+        attempt.close(ignored);
+    }
+
+    const Connect_Handler handler = std::move(handler_);
+    handler(error, std::move(socket));
+}
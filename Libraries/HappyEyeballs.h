@@ -0,0 +1,77 @@
+/*
+ * HappyEyeballs.h
+ * Purpose: Connects to the first reachable endpoint of a target by racing staggered attempts (RFC 8305).
+ *          The endpoints are reordered so that address families alternate, and a new attempt starts
+ *          whenever the previous one failed or has not succeeded within the attempt delay. The first
+ *          connection established wins and the other attempts are cancelled, so an unreachable address
+ *          costs at most the attempt delay instead of a full TCP connect timeout.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <boost/asio.hpp>
+
+class HappyEyeballs : public std::enable_shared_from_this<HappyEyeballs> {
+public:
+    using Connect_Handler = std::function<void(const boost::system::error_code&, boost::asio::ip::tcp::socket)>;
+
+    /*
+     * Constructor for the HappyEyeballs class.
+     *
+     * @param[in] executor: The executor the attempts and the handler run on.
+     * @param[in] endpoints: The endpoints of the target, in the resolver's order of preference.
+     * @param[in] attempt_delay: The time an attempt gets before the next one is started alongside it.
+     */
+    HappyEyeballs(const boost::asio::ip::tcp::socket::executor_type& executor, const std::vector<boost::asio::ip::tcp::endpoint>& endpoints, std::chrono::milliseconds attempt_delay);
+
+    /*
+     * Starts the race. The instance keeps itself alive until the handler has been invoked, which always happens
+     * through the executor, never from inside this call.
+     *
+     * @param[in] handler: The handler receiving the error code of the last failed attempt, or the connected socket.
+     */
+    void async_connect(Connect_Handler handler);
+
+    /*
+     * Cancels the race. The handler is invoked with `operation_aborted` unless a connection has already won.
+     */
+    void cancel();
+
+private:
+    /*
+     * Starts the next attempt and arms the timer starting the one after it.
+     */
+    void start_attempt();
+
+    /*
+     * Handles the completion of an attempt.
+     *
+     * @param[in] index: The attempt.
+     * @param[in] error: The error code of the connect.
+     */
+    void handle_attempt(std::size_t index, const boost::system::error_code& error);
+
+    /*
+     * Ends the race: closes the remaining attempts and invokes the handler.
+     *
+     * @param[in] error: The error code passed to the handler.
+     * @param[in] socket: The connected socket, or a closed one.
+     */
+    void finish(const boost::system::error_code& error, boost::asio::ip::tcp::socket socket);
+
+    boost::asio::ip::tcp::socket::executor_type executor_;
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints_; // Interleaved by address family.
+    std::vector<boost::asio::ip::tcp::socket> attempts_; // One per started attempt, reserved up front so they never move.
+    std::chrono::milliseconds attempt_delay_;
+    boost::asio::steady_timer attempt_timer_;
+    std::size_t pending_; // Attempts still connecting.
+    bool finished_;
+    boost::system::error_code last_error_;
+    Connect_Handler handler_;
+};
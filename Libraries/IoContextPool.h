@@ -0,0 +1,73 @@
+/*
+ * IoContextPool.h
+ * Purpose: Pool of Boost.Asio io_context instances, each driven by its own reactor thread.
+ *          Every io_context forms an independent shard, so sessions accepted on a shard
+ *          are serviced by a single thread for their whole lifetime.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+
+class IoContextPool {
+public:
+    /*
+     * Constructor for the IoContextPool class.
+     *
+     * @param[in] pool_size: The number of io_contexts (0 - one per hardware core).
+     * @param[in] pin_threads: True to pin each reactor thread to its own CPU core.
+     */
+    IoContextPool(std::size_t pool_size, bool pin_threads);
+
+    // Delete copy constructor to prevent unintended copying.
+    IoContextPool(const IoContextPool&) = delete;
+
+    // Delete assignment operator to prevent unintended copying.
+    IoContextPool& operator = (const IoContextPool&) = delete;
+
+    /*
+     * Runs every io_context on its own thread. The first io_context is run on the calling thread,
+     * so this call blocks until all of them have run out of work.
+     */
+    void run();
+
+    /*
+     * Releases the work guards so that each io_context returns once its pending work is done.
+     */
+    void stop();
+
+    /*
+     * Get the number of io_contexts in the pool.
+     *
+     * @return The number of io_contexts.
+     */
+    std::size_t size() const;
+
+    /*
+     * Get the io_context of a given shard.
+     *
+     * @param[in] index: The index of the shard.
+     * @return A reference to the io_context of the shard.
+     */
+    boost::asio::io_context& get_io_context(std::size_t index);
+
+private:
+    /*
+     * Pins the calling thread to a CPU core.
+     *
+     * @param[in] core: The index of the core.
+     */
+    void pin_current_thread(std::size_t core);
+
+    using Work_Guard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+    std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts_;
+    std::vector<Work_Guard> work_guards_;
+    std::vector<std::thread> threads_;
+    bool pin_threads_;
+};
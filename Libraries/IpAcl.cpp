@@ -0,0 +1,117 @@
+/*
+ * IpAcl.cpp
+ * Purpose: Destination access list compiled from the allowedIPs and blockedIPs configuration lists.
+ *          Address entries (single addresses or CIDR prefixes such as 10.0.0.0/8 or 2001:db8::/32)
+ *          are compiled into one prefix trie per address family and matched by longest prefix;
+ *          all other entries are host name rules handled by DomainPolicy.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "IpAcl.h"
+
+#include <charconv>
+
+namespace {
+    // Allowed list entry that allows every destination.
+    const std::string ALLOW_ALL = "all";
+
+    PrefixTrie<std::uint32_t, 1>::Key ipv4_key(const boost::asio::ip::address_v4& address) {
+        return { address.to_uint() };
+    }
+
+    PrefixTrie<std::uint64_t, 2>::Key ipv6_key(const boost::asio::ip::address_v6& address) {
+        const boost::asio::ip::address_v6::bytes_type bytes = address.to_bytes();
+        PrefixTrie<std::uint64_t, 2>::Key key{};
+        for (std::size_t i = 0; i < bytes.size(); ++i) {
+            key[i / 8] = (key[i / 8] << 8) | bytes[i];
+        }
+        return key;
+    }
+}
+
+IpAcl::IpAcl(const std::vector<std::string>& allowed, const std::vector<std::string>& blocked)
+    : allow_all_hosts_(false),
+    invalid_entries_(0) {
+    for (const std::string& entry : allowed) {
+        add_entry(entry, Acl_Action::Allow);
+    }
+    for (const std::string& entry : blocked) {
+        add_entry(entry, Acl_Action::Deny);
+    }
+
+    ipv4_rules_.compile();
+    ipv6_rules_.compile();
+}
+
+Acl_Action IpAcl::check_address(const boost::asio::ip::address& address) const {
+    if (address.is_v4()) {
+        return ipv4_rules_.lookup(ipv4_key(address.to_v4()));
+    }
+
+    const boost::asio::ip::address_v6 address_v6 = address.to_v6();
+    if (address_v6.is_v4_mapped()) {
+        return ipv4_rules_.lookup(ipv4_key(boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, address_v6)));
+    }
+    return ipv6_rules_.lookup(ipv6_key(address_v6));
+}
+
+Acl_Action IpAcl::check_host(const std::string& hostname) const {
+    const Acl_Action action = host_rules_.match(hostname);
+    if (action == Acl_Action::None && allow_all_hosts_) {
+        return Acl_Action::Allow;
+    }
+    return action;
+}
+
+std::size_t IpAcl::invalid_entries() const {
+    return invalid_entries_;
+}
+
+void IpAcl::add_entry(const std::string& entry, Acl_Action action) {
+    if (entry.empty()) {
+        return;
+    }
+
+    if (action == Acl_Action::Allow && entry == ALLOW_ALL) {
+        add_prefix(boost::asio::ip::address_v4::any(), 0, Acl_Action::Allow);
+        add_prefix(boost::asio::ip::address_v6::any(), 0, Acl_Action::Allow);
+        allow_all_hosts_ = true;
+        return;
+    }
+
+    boost::system::error_code error;
+    const std::size_t slash = entry.find('/');
+    if (slash == std::string::npos || entry[0] == '~' || entry[0] == '*') {
+        const boost::asio::ip::address address = boost::asio::ip::make_address(entry, error);
+        if (!error) {
+            add_prefix(address, address.is_v4() ? 32 : 128, action);
+        }
+        else if (!host_rules_.add_rule(entry, action)) {
+            ++invalid_entries_;
+        }
+        return;
+    }
+
+    const boost::asio::ip::address address = boost::asio::ip::make_address(entry.substr(0, slash), error);
+    unsigned length = 0;
+    const char* first = entry.data() + slash + 1;
+    const char* last = entry.data() + entry.size();
+    const std::from_chars_result parsed = std::from_chars(first, last, length);
+
+    if (error || first == last || parsed.ec != std::errc() || parsed.ptr != last || length > (address.is_v4() ? 32u : 128u)) {
+        ++invalid_entries_;
+        return;
+    }
+    add_prefix(address, length, action);
+}
+
+void IpAcl::add_prefix(const boost::asio::ip::address& address, unsigned length, Acl_Action action) {
+    if (address.is_v4()) {
+        ipv4_rules_.insert(ipv4_key(address.to_v4()), length, action);
+    }
+    else {
+        ipv6_rules_.insert(ipv6_key(address.to_v6()), length, action);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * IpAcl.h
+ * Purpose: Destination access list compiled from the allowedIPs and blockedIPs configuration lists.
+ *          Address entries (single addresses or CIDR prefixes such as 10.0.0.0/8 or 2001:db8::/32)
+ *          are compiled into one prefix trie per address family and matched by longest prefix;
+ *          all other entries are host name rules handled by DomainPolicy.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "DomainPolicy.h"
+#include "PrefixTrie.h"
+
+class IpAcl {
+public:
+    /*
+     * Constructor for the IpAcl class. Compiles the lists once; lookups never allocate.
+     * The entry "all" in the allowed list allows every destination that is not blocked by a more specific rule.
+     * Entries that are neither an address nor a prefix are treated as host name rules (see DomainPolicy).
+     *
+     * @param[in] allowed: The allowed addresses, prefixes and host names.
+     * @param[in] blocked: The blocked addresses, prefixes and host names.
+     */
+    IpAcl(const std::vector<std::string>& allowed, const std::vector<std::string>& blocked);
+
+    /*
+     * Finds the rule for a destination address. The longest matching prefix wins; for prefixes
+     * of equal length a deny rule takes precedence. IPv4-mapped IPv6 addresses match IPv4 rules.
+     *
+     * @param[in] address: The destination address.
+     * @return The action of the most specific matching rule, or `Acl_Action::None` if no rule matches.
+     */
+    Acl_Action check_address(const boost::asio::ip::address& address) const;
+
+    /*
+     * Finds the rule for a destination host name. The most specific host name rule wins, and names
+     * no rule matches are allowed only if the allowed list contains "all".
+     *
+     * @param[in] hostname: The destination host name.
+     * @return The action for the host name, or `Acl_Action::None` if no rule matches.
+     */
+    Acl_Action check_host(const std::string& hostname) const;
+
+    /*
+     * Get the number of entries that could not be compiled.
+     *
+     * @return The number of rejected entries.
+     */
+    std::size_t invalid_entries() const;
+
+private:
+    /*
+     * Compiles a single list entry.
+     *
+     * @param[in] entry: The address, prefix or host name.
+     * @param[in] action: The action attached to the entry.
+     */
+    void add_entry(const std::string& entry, Acl_Action action);
+
+    /*
+     * Adds an address prefix to the trie of its family.
+     *
+     * @param[in] address: The address of the prefix.
+     * @param[in] length: The prefix length in bits.
+     * @param[in] action: The action attached to the prefix.
+     */
+    void add_prefix(const boost::asio::ip::address& address, unsigned length, Acl_Action action);
+
+    PrefixTrie<std::uint32_t, 1> ipv4_rules_;
+    PrefixTrie<std::uint64_t, 2> ipv6_rules_;
+    DomainPolicy host_rules_;
+    bool allow_all_hosts_;
+    std::size_t invalid_entries_;
+};
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "./IpAcl.h"
+
+struct Case
+{
+    std::vector<std::string> allowed;
+    std::vector<std::string> blocked;
+    std::string address;
+    Acl_Action expected;
+};
+
+const char* to_string(Acl_Action action)
+{
+    switch (action)
+    {
+    case Acl_Action::Allow:
+        return "allow";
+    case Acl_Action::Deny:
+        return "deny";
+    default:
+        return "none";
+    }
+}
+
+int main()
+{
+    // Rules below a /16 prefix are reached through the first-level table; both children of such a node are covered,
+    // with allow and deny rules on either side.
+    const std::vector<Case> cases = {
+        { { "10.1.0.0/16" }, { "10.1.128.0/17" }, "10.1.200.1", Acl_Action::Deny },
+        { { "10.1.0.0/16" }, { "10.1.128.0/17" }, "10.1.5.1", Acl_Action::Allow },
+        { { "10.1.0.0/16" }, { "10.1.0.0/17" }, "10.1.5.1", Acl_Action::Deny },
+        { { "10.1.0.0/16" }, { "10.1.0.0/17" }, "10.1.200.1", Acl_Action::Allow },
+        { { "all" }, { "10.1.0.0/24", "10.1.128.0/24" }, "10.1.128.5", Acl_Action::Deny },
+        { { "all" }, { "10.1.0.0/24", "10.1.128.0/24" }, "10.1.0.5", Acl_Action::Deny },
+        { { "all" }, { "10.1.0.0/24", "10.1.128.0/24" }, "10.1.64.1", Acl_Action::Allow },
+        { { "10.1.0.0/17", "10.1.128.0/17" }, { "10.1.0.0/16" }, "10.1.5.1", Acl_Action::Allow },
+        { { "10.1.0.0/17", "10.1.128.0/17" }, { "10.1.0.0/16" }, "10.1.200.1", Acl_Action::Allow },
+        { { "10.1.0.0/17", "10.1.128.0/17" }, { "10.1.0.0/16" }, "10.2.0.1", Acl_Action::None },
+        { { "10.1.200.0/24" }, { "10.1.0.0/16" }, "10.1.200.7", Acl_Action::Allow },
+        { { "10.1.200.0/24" }, { "10.1.0.0/16" }, "10.1.201.7", Acl_Action::Deny },
+        { { "10.1.2.3" }, { "10.1.0.0/16" }, "10.1.2.3", Acl_Action::Allow },
+        { { "10.1.200.3" }, { "10.1.0.0/16" }, "10.1.200.3", Acl_Action::Allow },
+    };
+
+    int failures = 0;
+    for (const Case& test : cases)
+    {
+        const IpAcl acl(test.allowed, test.blocked);
+        const Acl_Action action = acl.check_address(boost::asio::ip::make_address(test.address));
+        if (action != test.expected)
+        {
+            std::cout << "FAIL " << test.address << ": " << to_string(action) << ", expected " << to_string(test.expected) << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << cases.size() - failures << " of " << cases.size() << " lookups match" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
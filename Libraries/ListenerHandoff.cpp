@@ -0,0 +1,260 @@
+/*
+ * ListenerHandoff.cpp
+ * Purpose: Passes the listening sockets of the proxy to a new process over a Unix socket (SCM_RIGHTS), so a binary
+ *          upgrade never refuses a connection: the new process accepts on the very sockets the old one listened on,
+ *          backlog included, and the old one only stops accepting once the new one confirmed it took them over.
+ *          Only available on Linux; elsewhere no sockets are taken and no successor is waited for.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "ListenerHandoff.h"
+
+#ifdef __linux__
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+namespace {
+    // Leads the message carrying the sockets, so a stray peer on the path is not mistaken for a proxy.
+    const std::uint32_t HANDOFF_MAGIC = 0x53354846;
+
+    // Byte a successor sends once it accepts on the sockets.
+    const char HANDOFF_CONFIRMATION = 'A';
+
+    // Most sockets one message carries; the kernel refuses more than 253 descriptors per message.
+    const std::size_t MAX_HANDOFF_SOCKETS = 128;
+
+    // Time a successor waits for the sockets before it binds its own.
+    const std::chrono::seconds HANDOFF_TIMEOUT(5);
+
+    struct Handoff_Header {
+        std::uint32_t magic;
+        std::uint32_t count;
+    };
+
+    union Handoff_Control {
+        cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int) * MAX_HANDOFF_SOCKETS)];
+    };
+}
+#endif
+
+ListenerHandoff::ListenerHandoff(boost::asio::io_context& io_context)
+#ifdef __linux__
+    : acceptor_(io_context),
+    predecessor_(-1),
+    confirmation_(0) {
+#else
+{
+    (void)io_context;
+#endif
+}
+
+ListenerHandoff::~ListenerHandoff() {
+#ifdef __linux__
+    if (predecessor_ != -1) {
+        ::close(predecessor_);
+    }
+    for (int socket : sockets_) {
+        ::close(socket);
+    }
+#endif
+}
+
+std::vector<ListenerHandoff::Native_Handle> ListenerHandoff::take(const std::string& path) {
+    std::vector<Native_Handle> sockets;
+#ifdef __linux__
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return sockets;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    const int connection = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connection == -1) {
+        return sockets;
+    }
+    const timeval timeout{ static_cast<time_t>(HANDOFF_TIMEOUT.count()), 0 };
+    ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (::connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        // No process listens, which is the case on a first start.
+        ::close(connection);
+        return sockets;
+    }
+
+    Handoff_Header header{};
+    iovec data{ &header, sizeof(header) };
+    Handoff_Control control{};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    const ssize_t length = ::recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+
+    for (cmsghdr* entry = CMSG_FIRSTHDR(&message); length > 0 && entry != nullptr; entry = CMSG_NXTHDR(&message, entry)) {
+        if (entry->cmsg_level == SOL_SOCKET && entry->cmsg_type == SCM_RIGHTS) {
+            const std::size_t count = (entry->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (std::size_t i = 0; i < count; ++i) {
+                int socket;
+                std::memcpy(&socket, CMSG_DATA(entry) + i * sizeof(int), sizeof(int));
+                sockets.push_back(socket);
+            }
+        }
+    }
+
+    if (length != static_cast<ssize_t>(sizeof(header)) || header.magic != HANDOFF_MAGIC || header.count != sockets.size()
+        || (message.msg_flags & MSG_CTRUNC) != 0) {
+        for (int socket : sockets) {
+            ::close(socket);
+        }
+        sockets.clear();
+        ::close(connection);
+        return sockets;
+    }
+    predecessor_ = connection;
+#else
+    (void)path;
+#endif
+    return sockets;
+}
+
+void ListenerHandoff::confirm() {
+#ifdef __linux__
+    if (predecessor_ == -1) {
+        return;
+    }
+    ::send(predecessor_, &HANDOFF_CONFIRMATION, 1, MSG_NOSIGNAL);
+    ::close(predecessor_);
+    predecessor_ = -1;
+#endif
+}
+
+bool ListenerHandoff::offer(const std::string& path, const std::vector<Native_Handle>& sockets, std::function<void()> handed_off) {
+#ifdef __linux__
+    if (path.empty() || sockets.empty() || sockets.size() > MAX_HANDOFF_SOCKETS) {
+        return false;
+    }
+
+    boost::system::error_code error;
+    ::unlink(path.c_str());
+    acceptor_.open(boost::asio::local::stream_protocol(), error);
+    if (!error) {
+        acceptor_.bind(boost::asio::local::stream_protocol::endpoint(path), error);
+    }
+    if (!error) {
+        // Only the owner may connect; the peer's user is checked again before the sockets are sent.
+        ::chmod(path.c_str(), S_IRUSR | S_IWUSR);
+        acceptor_.listen(1, error);
+    }
+    if (error) {
+        acceptor_.close(error);
+        return false;
+    }
+
+    // Duplicates keep the sockets valid for the successor even while the caller closes its acceptors.
+    for (Native_Handle socket : sockets) {
+        const int duplicate = ::fcntl(socket, F_DUPFD_CLOEXEC, 0);
+        if (duplicate != -1) {
+            sockets_.push_back(duplicate);
+        }
+    }
+    if (sockets_.empty()) {
+        acceptor_.close(error);
+        return false;
+    }
+    handed_off_ = std::move(handed_off);
+    accept_successor();
+    return true;
+#else
+    (void)path;
+    (void)sockets;
+    (void)handed_off;
+    return false;
+#endif
+}
+
+void ListenerHandoff::close() {
+#ifdef __linux__
+    // The path is left in place: a successor may have bound its own handoff socket there already.
+    boost::system::error_code ignored;
+    acceptor_.close(ignored);
+    for (int socket : sockets_) {
+        ::close(socket);
+    }
+    sockets_.clear();
+#endif
+}
+
+#ifdef __linux__
+void ListenerHandoff::accept_successor() {
+    auto successor = std::make_shared<boost::asio::local::stream_protocol::socket>(acceptor_.get_executor());
+    acceptor_.async_accept(*successor, [this, successor](const boost::system::error_code& error) {
+        if (!acceptor_.is_open()) {
+            return;
+        }
+        if (error) {
+            if (error == boost::asio::error::connection_aborted) {
+                accept_successor();
+            }
+            return;
+        }
+        if (!send_sockets(*successor)) {
+            accept_successor();
+            return;
+        }
+
+        // One successor at a time; this process keeps accepting until it confirms.
+        successor->async_read_some(boost::asio::buffer(&confirmation_, 1),
+            [this, successor](const boost::system::error_code& error, std::size_t length) {
+                if (!acceptor_.is_open()) {
+                    return;
+                }
+                if (error || length != 1 || confirmation_ != HANDOFF_CONFIRMATION) {
+                    accept_successor();
+                    return;
+                }
+                close();
+                if (handed_off_) {
+                    handed_off_();
+                }
+            });
+    });
+}
+
+bool ListenerHandoff::send_sockets(boost::asio::local::stream_protocol::socket& successor) {
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(successor.native_handle(), SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0 || credentials.uid != ::geteuid()) {
+        return false;
+    }
+
+    Handoff_Header header{ HANDOFF_MAGIC, static_cast<std::uint32_t>(sockets_.size()) };
+    iovec data{ &header, sizeof(header) };
+    Handoff_Control control{};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * sockets_.size());
+    cmsghdr* entry = CMSG_FIRSTHDR(&message);
+    entry->cmsg_level = SOL_SOCKET;
+    entry->cmsg_type = SCM_RIGHTS;
+    entry->cmsg_len = CMSG_LEN(sizeof(int) * sockets_.size());
+    std::memcpy(CMSG_DATA(entry), sockets_.data(), sizeof(int) * sockets_.size());
+
+    // The message is far smaller than the buffer of a new connection, so a non-blocking send completes at once.
+    return ::sendmsg(successor.native_handle(), &message, MSG_NOSIGNAL | MSG_DONTWAIT) == static_cast<ssize_t>(sizeof(header));
+}
+#endif
@@ -0,0 +1,93 @@
+/*
+ * ListenerHandoff.h
+ * Purpose: Passes the listening sockets of the proxy to a new process over a Unix socket (SCM_RIGHTS), so a binary
+ *          upgrade never refuses a connection: the new process accepts on the very sockets the old one listened on,
+ *          backlog included, and the old one only stops accepting once the new one confirmed it took them over.
+ *          Only available on Linux; elsewhere no sockets are taken and no successor is waited for.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+
+class ListenerHandoff {
+public:
+    using Native_Handle = boost::asio::ip::tcp::acceptor::native_handle_type;
+
+    /*
+     * Constructor for the ListenerHandoff class.
+     *
+     * @param[in] io_context: The io_context successors are accepted on.
+     */
+    explicit ListenerHandoff(boost::asio::io_context& io_context);
+
+    // Delete copy constructor to prevent closing the sockets twice.
+    ListenerHandoff(const ListenerHandoff&) = delete;
+
+    /*
+     * Destructor. Closes the connection to the previous process and the sockets kept for a successor.
+     */
+    ~ListenerHandoff();
+
+    // Delete assignment operator to prevent closing the sockets twice.
+    ListenerHandoff& operator = (const ListenerHandoff&) = delete;
+
+    /*
+     * Connects to the handoff socket of a running process and receives its listening sockets. Blocks for at most
+     * a few seconds, so a process that hangs cannot keep this one from starting.
+     *
+     * @param[in] path: The path of the handoff socket.
+     * @return The listening sockets, owned by the caller; empty if no process of the same user listens on the path.
+     */
+    std::vector<Native_Handle> take(const std::string& path);
+
+    /*
+     * Tells the previous process that the sockets taken from it are accepted on, after which it stops accepting.
+     * Does nothing if no sockets were taken.
+     */
+    void confirm();
+
+    /*
+     * Listens on the handoff socket for a successor. A successor of the same user that connects receives the
+     * listening sockets; once it confirms, the handler is called. Until then this process keeps accepting, and
+     * a successor that goes away without confirming is forgotten.
+     *
+     * @param[in] path: The path of the handoff socket; a file left there by a previous process is replaced.
+     * @param[in] sockets: The listening sockets; they are duplicated, so the caller keeps its own.
+     * @param[in] handed_off: Called on the io_context's thread once a successor took the sockets over.
+     * @return True if the handoff socket is listening.
+     */
+    bool offer(const std::string& path, const std::vector<Native_Handle>& sockets, std::function<void()> handed_off);
+
+    /*
+     * Stops waiting for a successor and closes the duplicated sockets. Must run on the io_context.
+     */
+    void close();
+
+private:
+#ifdef __linux__
+    /*
+     * Waits for the next successor to connect.
+     */
+    void accept_successor();
+
+    /*
+     * Sends the listening sockets to a successor.
+     *
+     * @param[in] successor: The connected successor.
+     * @return True if the successor runs as the same user and the sockets were sent.
+     */
+    bool send_sockets(boost::asio::local::stream_protocol::socket& successor);
+
+    boost::asio::local::stream_protocol::acceptor acceptor_;
+    int predecessor_; // Connection to the process the sockets were taken from, until they are confirmed.
+    std::vector<int> sockets_; // Duplicates of the listening sockets offered to a successor.
+    std::function<void()> handed_off_;
+    char confirmation_; // Receives the confirmation of a successor.
+#endif
+};
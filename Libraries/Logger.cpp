@@ -9,6 +9,15 @@
  */
 
 #include "Logger.h"
+#include "Metrics.h"
+
+#include <unordered_map>
+
+namespace
+{
+    // Maximum number of messages a worker thread takes from its ring at once.
+    const std::size_t BATCH_SIZE = 256;
+}
 
 void Logger::write(const spdlog::level::level_enum log_level, const std::string& IP, const std::string& message)
 {
@@ -20,27 +29,40 @@ void Logger::write(const spdlog::level::level_enum log_level, const std::string&
     logger->log(log_level, "Client IP: {}, {}", IP, message);
 }
 
-void Logger::work()
+void Logger::work(MpscRing<Log_Entry>& queue)
 {
-    while (true)
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        condition.wait(lock, [this] { return stop || !queue.empty(); });
+    std::vector<Log_Entry> batch;
+    batch.reserve(BATCH_SIZE);
 
-        if (stop && queue.empty())
+    // wait() returns false only once the ring is closed and fully drained.
+    while (queue.wait())
+    {
+        queue.pop_batch(batch, BATCH_SIZE);
+        for (const Log_Entry& entry : batch)
         {
-            lock.unlock();
-            return;
+            write(entry.log_level, entry.IP, entry.message);
         }
+        batch.clear();
+    }
+}
+
+void Logger::start_workers(const std::size_t queue_capacity)
+{
+    // At least one worker is needed to drain the rings.
+    const std::size_t worker_count = thread_count > 0 ? thread_count : 1;
 
-        const Log_Entry& entry = queue.front();
-        write(entry.log_level, entry.IP, entry.message);
-        queue.pop();
-        lock.unlock();
+    for (std::size_t i = 0; i < worker_count; ++i)
+    {
+        queues.emplace_back(std::make_unique<MpscRing<Log_Entry>>(queue_capacity));
+    }
+
+    for (std::size_t i = 0; i < worker_count; ++i)
+    {
+        threads.emplace_back([this, i] { work(*queues[i]); });
     }
 }
 
-Logger::Logger(const std::size_t thread_count) : path_to_file("C:\\Logs\\log.txt"), thread_count(thread_count), stop(false)
+Logger::Logger(const std::size_t thread_count, const std::size_t queue_capacity) : path_to_file("C:\\Logs\\log.txt"), thread_count(thread_count), next_queue(0)
 {
     file_sink = std::make_shared<spdlog::sinks::daily_file_sink_mt>(path_to_file, 0, 0);
     if (!file_sink)
@@ -56,13 +78,10 @@ Logger::Logger(const std::size_t thread_count) : path_to_file("C:\\Logs\\log.txt
 
     logger->set_pattern("[%Y-%m-%d %H:%M:%S] [%l] %v");
 
-    for (std::size_t i = 0; i < thread_count; ++i)
-    {
-        threads.emplace_back([this] { work(); });
-    }
+    start_workers(queue_capacity);
 }
 
-Logger::Logger(const std::size_t thread_count, const std::string& path_to_file) : path_to_file(path_to_file), thread_count(thread_count), stop(false)
+Logger::Logger(const std::size_t thread_count, const std::string& path_to_file, const std::size_t queue_capacity) : path_to_file(path_to_file), thread_count(thread_count), next_queue(0)
 {
     file_sink = std::make_shared<spdlog::sinks::daily_file_sink_mt>(path_to_file, 0, 0);
     if (!file_sink)
@@ -78,18 +97,15 @@ Logger::Logger(const std::size_t thread_count, const std::string& path_to_file)
 
     logger->set_pattern("[%Y-%m-%d %H:%M:%S] [%l] %v");
 
-    for (std::size_t i = 0; i < thread_count; ++i)
-    {
-        threads.emplace_back([this] { work(); });
-    }
+    start_workers(queue_capacity);
 }
 
 Logger::~Logger()
 {
-    std::unique_lock<std::mutex> lock(mutex);
-    stop = true;
-    condition.notify_all();
-    lock.unlock();
+    for (const std::unique_ptr<MpscRing<Log_Entry>>& queue : queues)
+    {
+        queue->close();
+    }
 
     for (std::thread& thread : threads)
     {
@@ -110,7 +126,17 @@ void Logger::add_to_queue(const std::string& IP, const std::string& message)
 
 void Logger::add_to_queue(const spdlog::level::level_enum log_level, const std::string& IP, const std::string& message)
 {
-    std::unique_lock<std::mutex> lock(mutex);
-    queue.push({ log_level, IP, message });
-    condition.notify_one();
+    // Each producer thread sticks to one ring of every Logger, which keeps its messages in order.
+    thread_local std::unordered_map<const Logger*, std::size_t> producer_indices;
+    auto [producer, inserted] = producer_indices.try_emplace(this, 0);
+    if (inserted)
+    {
+        producer->second = next_queue.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MpscRing<Log_Entry>& queue = *queues[producer->second % queues.size()];
+    if (!queue.try_push({ log_level, IP, message }))
+    {
+        Metrics::instance().add(Metrics::Counter::Log_Entries_Dropped);
+    }
 }
\ No newline at end of file
@@ -3,20 +3,24 @@
  * Purpose: Logger class for initializing and managing logging to a daily file.
  *          Provides a multi-threaded logging mechanism with queue-based message handling,
  *          enabling efficient and organized logging of messages from various sources.
+ *          Messages are handed to the writer threads through bounded lock-free rings, so sessions
+ *          never wait for disk I/O; when a ring is full the message is dropped and counted.
  *
  * @author Szymon Si¹ka³a
  * @version 1.2 30/08/2023
  */
 
 #pragma once
-#include <queue>
+#include <atomic>
+#include <memory>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/daily_file_sink.h>
 
+#include "MpscRing.h"
+
 struct Log_Entry
 {
     spdlog::level::level_enum log_level;
@@ -26,6 +30,10 @@ struct Log_Entry
 
 class Logger
 {
+public:
+    // Default number of messages each writer thread's ring can hold.
+    static constexpr std::size_t DEFAULT_QUEUE_CAPACITY = 65536;
+
 private:
     // Variables used to handle logs.
     std::shared_ptr<spdlog::logger> logger;
@@ -35,10 +43,8 @@ private:
     // Variables used to handle worker threads.
     std::size_t thread_count;
     std::vector <std::thread> threads;
-    std::queue<Log_Entry> queue;
-    std::mutex mutex;
-    std::condition_variable condition;
-    bool stop;
+    std::vector<std::unique_ptr<MpscRing<Log_Entry>>> queues; // One ring per worker thread.
+    std::atomic<std::size_t> next_queue; // Ring of the next thread that logs to this instance.
 
     /*
      * Log a message with the specified log level, client IP address, and message content.
@@ -51,10 +57,19 @@ private:
     void write(const spdlog::level::level_enum log_level, const std::string& IP, const std::string& message);
 
     /*
-     * Worker thread function to process log messages from the queue and write them to the log file.
-     * This function is used by multiple worker threads to process messages concurrently.
+     * Worker thread function to process log messages from a ring and write them to the log file.
+     * Each worker thread is the only consumer of its own ring and drains it in batches.
+     *
+     * @param[in] queue: The ring consumed by this worker thread.
+     */
+    void work(MpscRing<Log_Entry>& queue);
+
+    /*
+     * Creates the rings and starts the worker threads.
+     *
+     * @param[in] queue_capacity: The number of messages each ring can hold.
      */
-    void work();
+    void start_workers(const std::size_t queue_capacity);
 
 public:
     // Deleted default constructor to prevent creating an instance of Logger without specifying thread count.
@@ -65,9 +80,10 @@ public:
      * Log messages are written to a default file named "log.txt" in the "C:\Logs" directory.
      *
      * @param[in] thread_count: The number of worker threads to handle log messages.
+     * @param[in] queue_capacity: The number of messages each worker thread's ring can hold.
      * @throws std::runtime_error if unable to create file sink or logger.
      */
-    explicit Logger(const std::size_t thread_count);
+    explicit Logger(const std::size_t thread_count, const std::size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
 
     /*
      * Constructor that creates a Logger instance with a specified number of worker threads.
@@ -75,9 +91,10 @@ public:
      *
      * @param[in] path_to_file: Path to the log file.
      * @param[in] thread_count: The number of worker threads to handle log messages.
+     * @param[in] queue_capacity: The number of messages each worker thread's ring can hold.
      * @throws std::runtime_error if unable to create file sink or logger.
      */
-    explicit Logger(const std::size_t thread_count, const std::string& path_to_file);
+    explicit Logger(const std::size_t thread_count, const std::string& path_to_file, const std::size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
 
     // Delete copy constructor to prevent unintended copying
     Logger(const Logger&) = delete;
@@ -100,6 +117,7 @@ public:
 
     /*
      * Add a log message to the queue with a specified log level.
+     * Never blocks: if the calling thread's ring is full, the message is dropped and counted in Metrics.
      *
      * @param[in] log_level: The log level of the message.
      * @param[in] IP: The client's IP address.
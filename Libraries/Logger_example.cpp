@@ -28,8 +28,8 @@ int main()
     {
         std::size_t logger_thread_count = 2;
         Logger logger(logger_thread_count);
-        Logger logger2("C:\\Logs\\log_name.txt", logger_thread_count);
-        Logger logger3("C:\\Logs\\log_name", logger_thread_count);
+        Logger logger2(logger_thread_count, "C:\\Logs\\log_name.txt");
+        Logger logger3(logger_thread_count, "C:\\Logs\\log_name");
 
         std::size_t generator_thread_count = 4;
         std::vector <std::thread> threads;
@@ -0,0 +1,63 @@
+/*
+ * Metrics.cpp
+ * Purpose: Process-wide counters describing the health of the proxy (configuration reloads, dropped log entries,
+ *          rejected connections).
+ *          Counters are indexed by an enum and stored as relaxed atomics, so updating one never takes a lock.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "Metrics.h"
+
+namespace {
+    const char* const COUNTER_NAMES[] = {
+        "config_reloads",
+        "config_reload_failures",
+        "config_reload_last_duration_us",
+        "config_reload_total_duration_us",
+        "log_entries_dropped",
+        "database_entries_dropped",
+        "database_entries_failed",
+        "connections_rate_limited",
+        "connections_over_session_limit",
+        "connections_over_source_limit",
+        "accept_pauses",
+        "sessions_migrated",
+    };
+
+    static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<std::size_t>(Metrics::Counter::Count),
+        "Every counter needs a name.");
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::add(Counter counter, std::uint64_t value) {
+    counters_[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Metrics::set(Counter counter, std::uint64_t value) {
+    counters_[static_cast<std::size_t>(counter)].store(value, std::memory_order_relaxed);
+}
+
+std::uint64_t Metrics::get(Counter counter) const {
+    return counters_[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+const char* Metrics::name(Counter counter) {
+    return COUNTER_NAMES[static_cast<std::size_t>(counter)];
+}
+
+std::string Metrics::report() const {
+    std::string result;
+    for (std::size_t i = 0; i < counters_.size(); ++i) {
+        result += COUNTER_NAMES[i];
+        result += ' ';
+        result += std::to_string(counters_[i].load(std::memory_order_relaxed));
+        result += '\n';
+    }
+    return result;
+}
@@ -0,0 +1,85 @@
+/*
+ * Metrics.h
+ * Purpose: Process-wide counters describing the health of the proxy (configuration reloads, dropped log entries,
+ *          rejected connections).
+ *          Counters are indexed by an enum and stored as relaxed atomics, so updating one never takes a lock.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class Metrics {
+public:
+    enum class Counter : std::size_t {
+        Config_Reloads,                  // Successful configuration reloads.
+        Config_Reload_Failures,          // Reloads rejected because the file could not be parsed.
+        Config_Reload_Last_Duration_Us,  // Parse and compile time of the last reload, in microseconds.
+        Config_Reload_Total_Duration_Us, // Parse and compile time of all reloads, in microseconds.
+        Log_Entries_Dropped,             // Log entries rejected because the logger queue was full.
+        Database_Entries_Dropped,        // Log entries rejected because the database queue was full.
+        Database_Entries_Failed,         // Log entries lost because the transaction writing them failed.
+        Connections_Rate_Limited,        // Connections rejected because they arrived faster than the accept rate.
+        Connections_Over_Session_Limit,  // Connections rejected because the proxy ran the maximum number of sessions.
+        Connections_Over_Source_Limit,   // Connections rejected because their client address ran the maximum number of sessions.
+        Accept_Pauses,                   // Times accepting paused because the process ran out of file descriptors.
+        Sessions_Migrated,               // Tunnels moved to a less loaded reactor thread.
+        Count
+    };
+
+    /*
+     * Get the process-wide metrics instance.
+     *
+     * @return A reference to the metrics.
+     */
+    static Metrics& instance();
+
+    /*
+     * Adds a value to a counter.
+     *
+     * @param[in] counter: The counter to update.
+     * @param[in] value: The value to add.
+     */
+    void add(Counter counter, std::uint64_t value = 1);
+
+    /*
+     * Sets a counter to a value.
+     *
+     * @param[in] counter: The counter to update.
+     * @param[in] value: The new value.
+     */
+    void set(Counter counter, std::uint64_t value);
+
+    /*
+     * Get the current value of a counter.
+     *
+     * @param[in] counter: The counter to read.
+     * @return The value of the counter.
+     */
+    std::uint64_t get(Counter counter) const;
+
+    /*
+     * Get the name of a counter as used in reports.
+     *
+     * @param[in] counter: The counter.
+     * @return The name of the counter.
+     */
+    static const char* name(Counter counter);
+
+    /*
+     * Formats all counters as "name value" lines.
+     *
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    Metrics() = default;
+
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Counter::Count)> counters_{};
+};
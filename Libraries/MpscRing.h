@@ -0,0 +1,208 @@
+/*
+ * MpscRing.h
+ * Purpose: Bounded multi-producer/single-consumer ring of preallocated cells with wait-free producers.
+ *          Producers reserve room and claim a cell with two fetch-and-adds, so a push finishes in a bounded
+ *          number of steps whatever the other threads do (wait-free): when the ring is full the entry is
+ *          rejected instead. The consumer drains entries in batches and sleeps on a semaphore when the
+ *          ring is empty, for at most a given time if it wants; producers only release it while it is asleep.
+ *          Based on Dmitry Vyukov's bounded queue, with per-cell sequence numbers.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <semaphore>
+#include <vector>
+
+template <typename T>
+class MpscRing {
+public:
+    /*
+     * Constructor for the MpscRing class.
+     *
+     * @param[in] capacity: The number of entries the ring can hold, rounded up to a power of two.
+     */
+    explicit MpscRing(std::size_t capacity)
+        : capacity_(round_up(capacity)),
+        mask_(capacity_ - 1),
+        cells_(std::make_unique<Cell[]>(capacity_)) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Delete copy constructor to prevent unintended copying.
+    MpscRing(const MpscRing&) = delete;
+
+    // Delete assignment operator to prevent unintended copying.
+    MpscRing& operator = (const MpscRing&) = delete;
+
+    /*
+     * Adds an entry. Safe to call from any number of threads.
+     *
+     * @param[in] value: The entry to add; it is left untouched if the ring is full.
+     * @return True if the entry was added, false if the ring is full or closed.
+     */
+    bool try_push(T&& value) {
+        if (closed_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        // A reservation is only granted while fewer than capacity_ entries are unconsumed, so the cell the
+        // ticket below names has always been released by the consumer and no producer ever waits for it.
+        if (reserved_.fetch_add(1, std::memory_order_acq_rel) >= capacity_) {
+            reserved_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        const std::size_t position = tail_.fetch_add(1, std::memory_order_acq_rel);
+        Cell* cell = &cells_[position & mask_];
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        // Pairs with the fence in sleep_until_available(): either the consumer sees the entry or we see that it sleeps.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_waiting_.load(std::memory_order_relaxed)) {
+            wake_consumer();
+        }
+        return true;
+    }
+
+    /*
+     * Moves up to `max_count` entries into `batch`. Must only be called by the consumer thread.
+     *
+     * @param[out] batch: The vector the entries are appended to.
+     * @param[in] max_count: The maximum number of entries to take.
+     * @return The number of entries taken.
+     */
+    std::size_t pop_batch(std::vector<T>& batch, std::size_t max_count) {
+        std::size_t count = 0;
+        while (count < max_count) {
+            Cell& cell = cells_[head_ & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+                break;
+            }
+
+            batch.push_back(std::move(cell.value));
+            cell.sequence.store(head_ + capacity_, std::memory_order_release);
+            ++head_;
+            ++count;
+        }
+        if (count > 0) {
+            // Released only after the cells, so a producer granted the room finds its cell free.
+            reserved_.fetch_sub(count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /*
+     * Blocks the consumer thread until an entry is available or the ring is closed.
+     *
+     * @return False if the ring is closed and empty, true otherwise.
+     */
+    bool wait() {
+        return sleep_until_available(nullptr);
+    }
+
+    /*
+     * Blocks the consumer thread until an entry is available, the ring is closed or the deadline has passed.
+     *
+     * @param[in] deadline: The time the consumer waits until at most.
+     * @return True if an entry is available, false otherwise.
+     */
+    bool wait_until(std::chrono::steady_clock::time_point deadline) {
+        return sleep_until_available(&deadline);
+    }
+
+    /*
+     * Rejects further entries and wakes the consumer, which drains what is left and then stops waiting.
+     */
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        wake_consumer();
+    }
+
+    /*
+     * Check whether the ring has been closed.
+     *
+     * @return True once close() has been called.
+     */
+    bool closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    /*
+     * Get the number of entries the ring can hold.
+     *
+     * @return The capacity of the ring.
+     */
+    std::size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    // Cache line size used to keep the producer and consumer indices apart.
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t round_up(std::size_t capacity) {
+        std::size_t result = 2;
+        while (result < capacity) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    bool sleep_until_available(const std::chrono::steady_clock::time_point* deadline) {
+        while (true) {
+            consumer_waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (!empty()) {
+                consumer_waiting_.store(false, std::memory_order_relaxed);
+                return true;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                consumer_waiting_.store(false, std::memory_order_relaxed);
+                return false;
+            }
+
+            // A release left over from an earlier wake-up only costs another look at the ring.
+            if (deadline == nullptr) {
+                signal_.acquire();
+            }
+            else if (!signal_.try_acquire_until(*deadline)) {
+                consumer_waiting_.store(false, std::memory_order_relaxed);
+                return !empty();
+            }
+            consumer_waiting_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    bool empty() const {
+        return cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    void wake_consumer() {
+        signal_.release();
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const std::unique_ptr<Cell[]> cells_;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_{ 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> reserved_{ 0 }; // Entries pushed or being pushed and not yet consumed.
+    alignas(CACHE_LINE_SIZE) std::size_t head_ = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> consumer_waiting_{ false };
+    std::counting_semaphore<> signal_{ 0 };
+    std::atomic<bool> closed_{ false };
+};
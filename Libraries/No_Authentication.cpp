@@ -11,11 +11,18 @@
 
 No_Authentication::No_Authentication() {}
 
-Authentication_Result No_Authentication::authenticate(boost::asio::ip::tcp::socket socket)
+void No_Authentication::async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer&, Authentication_Handler handler)
 {
-    const std::array<unsigned char, 2> response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0x00) };
-    boost::asio::write(socket, boost::asio::buffer(response));
+    response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0x00) };
+    boost::asio::async_write(socket, boost::asio::buffer(response),
+        [self = shared_from_this(), handler = std::move(handler)](const boost::system::error_code& error, std::size_t)
+        {
+            if (error)
+            {
+                handler({ false, 0, "Error while sending method selection: " + error.message() });
+                return;
+            }
 
-    Authentication_Result result = { true, std::move(socket), 0,  "" };
-    return result;
+            handler({ true, 0, "" });
+        });
 }
\ No newline at end of file
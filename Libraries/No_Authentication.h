@@ -16,10 +16,14 @@ public:
     No_Authentication();
 
     /*
-     * Abstract method for authentication.
+     * Asynchronous authentication for the no authentication strategy.
      *
      * @param[in] socket: The socket to authenticate.
-     * @return `Authentication_Result` struct indicating whether authentication is successful and associated details.
+     * @param[in] buffer: The handshake buffer.
+     * @param[in] handler: The handler receiving the `Authentication_Result` of the exchange.
      */
-    Authentication_Result authenticate(boost::asio::ip::tcp::socket socket) override;
+    void async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer, Authentication_Handler handler) override;
+
+private:
+    std::array<unsigned char, 2> response;
 };
\ No newline at end of file
@@ -0,0 +1,228 @@
+/*
+ * Policy.cpp
+ * Purpose: Immutable snapshot of the settings compiled from a ProxyConfiguration that apply to new connections:
+ *          the destination access list, the port rules, the authentication settings, the relay engine and its
+ *          buffers, the handshake, connect and idle timeouts, TCP keepalive, admission limits, bandwidth limits,
+ *          relay scheduling quanta, reactor rebalancing and the drain timeout.
+ *          A snapshot is built once and shared by all sessions through std::shared_ptr<const Policy>,
+ *          so accepting a connection never copies the configuration.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "Policy.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include "BufferPool.h"
+
+namespace {
+    // Allowed port list entry that allows every port.
+    const int ALLOW_ALL_PORTS = -1;
+
+    // Bounds of the connection attempt delay (RFC 8305, section 8).
+    const int MIN_CONNECT_ATTEMPT_DELAY_MS = 10;
+    const int MAX_CONNECT_ATTEMPT_DELAY_MS = 2000;
+
+    // Rounds a configured buffer size up to a size class of the buffer pool.
+    std::size_t buffer_size(int size) {
+        const std::size_t clamped = std::clamp(static_cast<std::size_t>((std::max)(size, 0)), BufferPool::MIN_BUFFER_SIZE, BufferPool::MAX_BUFFER_SIZE);
+        return std::bit_ceil(clamped);
+    }
+}
+
+Policy::Policy(const ProxyConfiguration& config)
+    : acl_(config.getAllowedIPs(), config.getBlockedIPs()),
+    priority_users_(config.getPriorityUsers().begin(), config.getPriorityUsers().end()),
+    authentication_method_(config.getAuthenticationMethod()),
+    username_(config.getUsername()),
+    password_(config.getPassword()),
+    relay_engine_(config.getRelayEngine()),
+    relay_depth_(static_cast<std::size_t>(std::clamp(config.getRelayPipelineDepth(), 1, static_cast<int>(MAX_RELAY_DEPTH)))),
+    relay_min_buffer_size_(buffer_size(config.getRelayMinBufferSize())),
+    relay_max_buffer_size_((std::max)(relay_min_buffer_size_, buffer_size(config.getRelayMaxBufferSize()))),
+    optimistic_connect_(config.getOptimisticConnect()),
+    optimistic_buffer_size_(buffer_size(config.getOptimisticBufferSize())),
+    connect_attempt_delay_(std::clamp(config.getConnectAttemptDelayMs(), MIN_CONNECT_ATTEMPT_DELAY_MS, MAX_CONNECT_ATTEMPT_DELAY_MS)),
+    handshake_timeout_((std::max)(config.getHandshakeTimeout(), 0)),
+    connect_timeout_((std::max)(config.getConnectTimeout(), 0)),
+    idle_timeout_((std::max)(config.getIdleTimeout(), 0)),
+    keep_alive_idle_((std::max)(config.getTcpKeepAliveIdle(), 0)),
+    keep_alive_interval_((std::max)(config.getTcpKeepAliveInterval(), 1)),
+    max_sessions_(static_cast<std::size_t>((std::max)(config.getMaxSessions(), 0))),
+    max_sessions_per_source_(static_cast<std::size_t>((std::max)(config.getMaxSessionsPerIp(), 0))),
+    accept_rate_((std::max)(config.getAcceptRate(), 0)),
+    accept_burst_((std::max)(config.getAcceptBurst(), 1)),
+    pending_accepts_(static_cast<std::size_t>(std::clamp(config.getPendingAccepts(), 1, static_cast<int>(MAX_PENDING_ACCEPTS)))),
+    reject_with_reset_(config.getRejectWithReset()),
+    session_rate_limit_(static_cast<std::uint64_t>((std::max)(config.getSessionRateLimit(), 0))),
+    user_rate_limit_(static_cast<std::uint64_t>((std::max)(config.getUserRateLimit(), 0))),
+    source_rate_limit_(static_cast<std::uint64_t>((std::max)(config.getIpRateLimit(), 0))),
+    rate_limit_burst_((std::max)(static_cast<std::uint64_t>((std::max)(config.getRateLimitBurst(), 0)), MIN_RATE_LIMIT_BURST)),
+    relay_quantum_(config.getRelayQuantum() > 0 ? (std::max)(static_cast<std::size_t>(config.getRelayQuantum()), MIN_RELAY_QUANTUM) : 0),
+    priority_weight_(static_cast<std::size_t>(std::clamp(config.getPriorityWeight(), 1, static_cast<int>(MAX_PRIORITY_WEIGHT)))),
+    rebalance_interval_((std::max)(config.getRebalanceInterval(), 0)),
+    rebalance_threshold_(std::clamp(config.getRebalanceThreshold(), 0, 100) / 100.0),
+    rebalance_min_rate_(static_cast<std::uint64_t>((std::max)(config.getRebalanceMinRate(), 0))),
+    drain_timeout_((std::max)(config.getDrainTimeout(), 0)) {
+    for (int port : config.getAllowedPorts()) {
+        if (port == ALLOW_ALL_PORTS) {
+            allowed_ports_.set();
+        }
+        else if (port >= 0 && port < static_cast<int>(PORT_COUNT)) {
+            allowed_ports_.set(static_cast<std::size_t>(port));
+        }
+    }
+
+    for (int port : config.getBlockedPorts()) {
+        if (port >= 0 && port < static_cast<int>(PORT_COUNT)) {
+            blocked_ports_.set(static_cast<std::size_t>(port));
+        }
+    }
+
+    for (int port : config.getPriorityPorts()) {
+        if (port >= 0 && port < static_cast<int>(PORT_COUNT)) {
+            priority_ports_.set(static_cast<std::size_t>(port));
+        }
+    }
+}
+
+const IpAcl& Policy::acl() const {
+    return acl_;
+}
+
+Acl_Action Policy::check_port(unsigned short port) const {
+    if (blocked_ports_.test(port)) {
+        return Acl_Action::Deny;
+    }
+    return allowed_ports_.test(port) ? Acl_Action::Allow : Acl_Action::None;
+}
+
+int Policy::authentication_method() const {
+    return authentication_method_;
+}
+
+const std::string& Policy::username() const {
+    return username_;
+}
+
+const std::string& Policy::password() const {
+    return password_;
+}
+
+int Policy::relay_engine() const {
+    return relay_engine_;
+}
+
+std::size_t Policy::relay_depth() const {
+    return relay_depth_;
+}
+
+std::size_t Policy::relay_min_buffer_size() const {
+    return relay_min_buffer_size_;
+}
+
+std::size_t Policy::relay_max_buffer_size() const {
+    return relay_max_buffer_size_;
+}
+
+bool Policy::optimistic_connect() const {
+    return optimistic_connect_;
+}
+
+std::size_t Policy::optimistic_buffer_size() const {
+    return optimistic_buffer_size_;
+}
+
+std::chrono::milliseconds Policy::connect_attempt_delay() const {
+    return connect_attempt_delay_;
+}
+
+std::chrono::seconds Policy::handshake_timeout() const {
+    return handshake_timeout_;
+}
+
+std::chrono::seconds Policy::connect_timeout() const {
+    return connect_timeout_;
+}
+
+std::chrono::seconds Policy::idle_timeout() const {
+    return idle_timeout_;
+}
+
+std::chrono::seconds Policy::keep_alive_idle() const {
+    return keep_alive_idle_;
+}
+
+std::chrono::seconds Policy::keep_alive_interval() const {
+    return keep_alive_interval_;
+}
+
+std::size_t Policy::max_sessions() const {
+    return max_sessions_;
+}
+
+std::size_t Policy::max_sessions_per_source() const {
+    return max_sessions_per_source_;
+}
+
+double Policy::accept_rate() const {
+    return accept_rate_;
+}
+
+double Policy::accept_burst() const {
+    return accept_burst_;
+}
+
+std::size_t Policy::pending_accepts() const {
+    return pending_accepts_;
+}
+
+bool Policy::reject_with_reset() const {
+    return reject_with_reset_;
+}
+
+std::uint64_t Policy::session_rate_limit() const {
+    return session_rate_limit_;
+}
+
+std::uint64_t Policy::user_rate_limit() const {
+    return user_rate_limit_;
+}
+
+std::uint64_t Policy::source_rate_limit() const {
+    return source_rate_limit_;
+}
+
+std::uint64_t Policy::rate_limit_burst() const {
+    return rate_limit_burst_;
+}
+
+std::size_t Policy::relay_quantum(unsigned short port, const std::string& user) const {
+    if (relay_quantum_ == 0) {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    if (priority_ports_.test(port) || (!user.empty() && priority_users_.contains(user))) {
+        return relay_quantum_ * priority_weight_;
+    }
+    return relay_quantum_;
+}
+
+std::chrono::milliseconds Policy::rebalance_interval() const {
+    return rebalance_interval_;
+}
+
+double Policy::rebalance_threshold() const {
+    return rebalance_threshold_;
+}
+
+std::uint64_t Policy::rebalance_min_rate() const {
+    return rebalance_min_rate_;
+}
+
+std::chrono::seconds Policy::drain_timeout() const {
+    return drain_timeout_;
+}
@@ -0,0 +1,317 @@
+/*
+ * Policy.h
+ * Purpose: Immutable snapshot of the settings compiled from a ProxyConfiguration that apply to new connections:
+ *          the destination access list, the port rules, the authentication settings, the relay engine and its
+ *          buffers, the handshake, connect and idle timeouts, TCP keepalive, admission limits, bandwidth limits,
+ *          relay scheduling quanta, reactor rebalancing and the drain timeout.
+ *          A snapshot is built once and shared by all sessions through std::shared_ptr<const Policy>,
+ *          so accepting a connection never copies the configuration.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+#include "IpAcl.h"
+#include "ProxyConfiguration.h"
+
+class Policy {
+public:
+    /*
+     * Constructor for the Policy class. Compiles the lists of the configuration.
+     *
+     * @param[in] config: The ProxyConfiguration instance with proxy server configuration.
+     */
+    explicit Policy(const ProxyConfiguration& config);
+
+    /*
+     * Get the compiled destination access list.
+     *
+     * @return A reference to the access list.
+     */
+    const IpAcl& acl() const;
+
+    /*
+     * Finds the rule for a destination port. A blocked port is rejected even if all ports are allowed.
+     *
+     * @param[in] port: The destination port.
+     * @return `Acl_Action::Deny` if the port is blocked, `Acl_Action::Allow` if it is allowed, `Acl_Action::None` otherwise.
+     */
+    Acl_Action check_port(unsigned short port) const;
+
+    /*
+     * Get the configured authentication method.
+     *
+     * @return The authentication method (-1 - any available, 0 - none, 1 - GSSAPI, 2 - username and password).
+     */
+    int authentication_method() const;
+
+    /*
+     * Get the username for username/password authentication.
+     *
+     * @return A reference to the username.
+     */
+    const std::string& username() const;
+
+    /*
+     * Get the password for username/password authentication.
+     *
+     * @return A reference to the password.
+     */
+    const std::string& password() const;
+
+    /*
+     * Get the relay engine for established tunnels.
+     *
+     * @return The relay engine (0 - copy, 1 - splice where available, 2 - io_uring where available).
+     */
+    int relay_engine() const;
+
+    /*
+     * Get the number of buffers per direction the copy relay may fill ahead of the writes, which also bounds the
+     * chunks a direction of the io_uring relay holds before it stops receiving.
+     *
+     * @return The pipeline depth, between 1 and MAX_RELAY_DEPTH.
+     */
+    std::size_t relay_depth() const;
+
+    /*
+     * Get the smallest relay buffer, used by new and idle flows.
+     *
+     * @return The size in bytes, a power of two within the sizes of BufferPool.
+     */
+    std::size_t relay_min_buffer_size() const;
+
+    /*
+     * Get the largest relay buffer, reached by bulk transfers.
+     *
+     * @return The size in bytes, a power of two within the sizes of BufferPool and at least the smallest size.
+     */
+    std::size_t relay_max_buffer_size() const;
+
+    /*
+     * Get whether CONNECT requests are answered with success before the target is connected.
+     *
+     * @return True if replies are optimistic.
+     */
+    bool optimistic_connect() const;
+
+    /*
+     * Get the amount of client data buffered while an optimistic connect is in flight.
+     *
+     * @return The size in bytes, a power of two within the sizes of BufferPool.
+     */
+    std::size_t optimistic_buffer_size() const;
+
+    /*
+     * Get the time a connection attempt gets before the next address of the target is tried alongside it.
+     *
+     * @return The delay, between 10 ms and 2 s (RFC 8305).
+     */
+    std::chrono::milliseconds connect_attempt_delay() const;
+
+    /*
+     * Get the time a client gets to complete the handshake.
+     *
+     * @return The timeout, zero if there is none.
+     */
+    std::chrono::seconds handshake_timeout() const;
+
+    /*
+     * Get the time connecting to a target may take, including resolving its name.
+     *
+     * @return The timeout, zero if there is none.
+     */
+    std::chrono::seconds connect_timeout() const;
+
+    /*
+     * Get the time a tunnel may relay nothing in either direction before it is closed.
+     *
+     * @return The timeout, zero if there is none.
+     */
+    std::chrono::seconds idle_timeout() const;
+
+    /*
+     * Get the time a connection is idle before the kernel starts sending TCP keepalive probes.
+     *
+     * @return The time, zero if keepalive is disabled.
+     */
+    std::chrono::seconds keep_alive_idle() const;
+
+    /*
+     * Get the time between TCP keepalive probes.
+     *
+     * @return The time, at least one second.
+     */
+    std::chrono::seconds keep_alive_interval() const;
+
+    /*
+     * Get the maximum number of concurrent sessions.
+     *
+     * @return The number of sessions, 0 for no limit.
+     */
+    std::size_t max_sessions() const;
+
+    /*
+     * Get the maximum number of concurrent sessions of one client IP address.
+     *
+     * @return The number of sessions, 0 for no limit.
+     */
+    std::size_t max_sessions_per_source() const;
+
+    /*
+     * Get the number of connections accepted per second.
+     *
+     * @return The rate, 0 for no limit.
+     */
+    double accept_rate() const;
+
+    /*
+     * Get the number of connections accepted at once after a quiet period.
+     *
+     * @return The burst size, at least one.
+     */
+    double accept_burst() const;
+
+    /*
+     * Get the number of accepts kept outstanding on every listening socket.
+     *
+     * @return The number of accepts, between 1 and MAX_PENDING_ACCEPTS.
+     */
+    std::size_t pending_accepts() const;
+
+    /*
+     * Get whether connections over the limits are reset instead of answered with a SOCKS failure reply.
+     *
+     * @return True if rejected connections are reset.
+     */
+    bool reject_with_reset() const;
+
+    /*
+     * Get the bytes per second a session may relay in both directions together.
+     *
+     * @return The rate, 0 for no limit.
+     */
+    std::uint64_t session_rate_limit() const;
+
+    /*
+     * Get the bytes per second the sessions of one authenticated user may relay together.
+     *
+     * @return The rate, 0 for no limit.
+     */
+    std::uint64_t user_rate_limit() const;
+
+    /*
+     * Get the bytes per second the sessions of one client IP address may relay together.
+     *
+     * @return The rate, 0 for no limit.
+     */
+    std::uint64_t source_rate_limit() const;
+
+    /*
+     * Get the bytes a rate limited session, user or client address may relay at once after a quiet period.
+     *
+     * @return The burst size in bytes, at least MIN_RATE_LIMIT_BURST.
+     */
+    std::uint64_t rate_limit_burst() const;
+
+    /*
+     * Get the bytes a tunnel direction may relay per scheduling round before it lets the other ready sessions of its
+     * reactor run. Tunnels to a priority port or of a priority user get a round that many times larger.
+     *
+     * @param[in] port: The destination port of the tunnel.
+     * @param[in] user: The authenticated user name, empty if the session has none.
+     * @return The quantum in bytes, at least MIN_RELAY_QUANTUM; the largest size_t if rounds are unlimited.
+     */
+    std::size_t relay_quantum(unsigned short port, const std::string& user) const;
+
+    /*
+     * Get the time between load samples of the reactor threads.
+     *
+     * @return The interval, zero if tunnels are never moved between threads.
+     */
+    std::chrono::milliseconds rebalance_interval() const;
+
+    /*
+     * Get the difference in busy time between two reactor threads above which the idle one takes over a tunnel.
+     *
+     * @return The difference as a share of the interval, between 0 and 1.
+     */
+    double rebalance_threshold() const;
+
+    /*
+     * Get the bytes per second a tunnel must relay to be moved to another reactor thread.
+     *
+     * @return The rate in bytes per second.
+     */
+    std::uint64_t rebalance_min_rate() const;
+
+    /*
+     * Get the time existing tunnels get to finish when the server stops accepting.
+     *
+     * @return The timeout, zero if tunnels are closed at once.
+     */
+    std::chrono::seconds drain_timeout() const;
+
+    // Upper bound of the pipeline depth, which bounds the relay memory of a session.
+    static constexpr std::size_t MAX_RELAY_DEPTH = 16;
+
+    // Upper bound of the accepts kept outstanding per listening socket.
+    static constexpr std::size_t MAX_PENDING_ACCEPTS = 64;
+
+    // Lower bound of the rate limit burst, so a shaped relay is never starved into reading a few bytes at a time.
+    static constexpr std::uint64_t MIN_RATE_LIMIT_BURST = 4096;
+
+    // Lower bound of the relay quantum, so a scheduled relay still reads whole buffers.
+    static constexpr std::size_t MIN_RELAY_QUANTUM = 4096;
+
+    // Upper bound of the priority weight.
+    static constexpr std::size_t MAX_PRIORITY_WEIGHT = 64;
+
+private:
+    static constexpr std::size_t PORT_COUNT = 65536;
+
+    IpAcl acl_;
+    std::bitset<PORT_COUNT> allowed_ports_;
+    std::bitset<PORT_COUNT> blocked_ports_;
+    std::bitset<PORT_COUNT> priority_ports_;
+    std::unordered_set<std::string> priority_users_;
+    int authentication_method_;
+    std::string username_;
+    std::string password_;
+    int relay_engine_;
+    std::size_t relay_depth_;
+    std::size_t relay_min_buffer_size_;
+    std::size_t relay_max_buffer_size_;
+    bool optimistic_connect_;
+    std::size_t optimistic_buffer_size_;
+    std::chrono::milliseconds connect_attempt_delay_;
+    std::chrono::seconds handshake_timeout_;
+    std::chrono::seconds connect_timeout_;
+    std::chrono::seconds idle_timeout_;
+    std::chrono::seconds keep_alive_idle_;
+    std::chrono::seconds keep_alive_interval_;
+    std::size_t max_sessions_;
+    std::size_t max_sessions_per_source_;
+    double accept_rate_;
+    double accept_burst_;
+    std::size_t pending_accepts_;
+    bool reject_with_reset_;
+    std::uint64_t session_rate_limit_;
+    std::uint64_t user_rate_limit_;
+    std::uint64_t source_rate_limit_;
+    std::uint64_t rate_limit_burst_;
+    std::size_t relay_quantum_; // Zero if rounds are unlimited.
+    std::size_t priority_weight_;
+    std::chrono::milliseconds rebalance_interval_;
+    double rebalance_threshold_;
+    std::uint64_t rebalance_min_rate_;
+    std::chrono::seconds drain_timeout_;
+};
@@ -0,0 +1,243 @@
+/*
+ * PrefixTrie.h
+ * Purpose: Path-compressed binary (Patricia) trie over fixed-width integer keys, used for
+ *          longest-prefix-match lookups of IPv4 and IPv6 address prefixes.
+ *          Nodes live in one contiguous vector and are linked by index. Once built, the trie can be
+ *          compiled into a direct-indexed table over the first STRIDE_BITS bits of the key, so a
+ *          lookup jumps straight past the densely populated top levels and never allocates.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Decision attached to an address or host name rule.
+enum class Acl_Action : std::uint8_t {
+    None,  // No rule matches.
+    Allow, // The destination is explicitly allowed.
+    Deny   // The destination is explicitly blocked.
+};
+
+template <typename Word, std::size_t Words>
+class PrefixTrie {
+public:
+    // The key is stored most significant word first, in host byte order.
+    using Key = std::array<Word, Words>;
+
+    static constexpr unsigned WORD_BITS = sizeof(Word) * 8;
+    static constexpr unsigned MAX_BITS = WORD_BITS * Words;
+
+    /*
+     * Adds a prefix to the trie. When the same prefix is added twice, Deny takes precedence over Allow.
+     *
+     * @param[in] key: The address of the prefix; bits past the prefix length are ignored.
+     * @param[in] length: The prefix length in bits.
+     * @param[in] action: The action attached to the prefix.
+     */
+    void insert(const Key& key, unsigned length, Acl_Action action) {
+        const Key prefix = mask(key, length);
+
+        if (root_ == NONE) {
+            root_ = add_node(prefix, length, action);
+            return;
+        }
+
+        // Nodes are linked by index because adding a node may reallocate the vector.
+        std::uint32_t parent = NONE;
+        unsigned parent_bit = 0;
+        std::uint32_t current = root_;
+        while (true) {
+            const unsigned node_length = nodes_[current].length;
+            const unsigned common = common_prefix(nodes_[current].key, prefix, node_length < length ? node_length : length);
+
+            if (common < node_length) {
+                // The new prefix diverges inside this node's compressed path: split it.
+                const std::uint32_t branch = add_node(mask(prefix, common), common, Acl_Action::None);
+                nodes_[branch].children[bit(nodes_[current].key, common)] = current;
+
+                if (common == length) {
+                    nodes_[branch].action = action;
+                }
+                else {
+                    const std::uint32_t leaf = add_node(prefix, length, action);
+                    nodes_[branch].children[bit(prefix, common)] = leaf;
+                }
+                set_link(parent, parent_bit, branch);
+                return;
+            }
+
+            if (node_length == length) {
+                Node& node = nodes_[current];
+                if (action == Acl_Action::Deny || node.action == Acl_Action::None) {
+                    node.action = action;
+                }
+                return;
+            }
+
+            const unsigned next = bit(prefix, node_length);
+            if (nodes_[current].children[next] == NONE) {
+                const std::uint32_t leaf = add_node(prefix, length, action);
+                nodes_[current].children[next] = leaf;
+                return;
+            }
+            parent = current;
+            parent_bit = next;
+            current = nodes_[current].children[next];
+        }
+    }
+
+    /*
+     * Builds the first-level lookup table. Must be called again after further insertions.
+     */
+    void compile() {
+        if (root_ == NONE) {
+            stride_table_.clear();
+            return;
+        }
+        stride_table_.assign(std::size_t(1) << STRIDE_BITS, { NONE, Acl_Action::None });
+
+        for (std::size_t slot = 0; slot < stride_table_.size(); ++slot) {
+            Key key{};
+            key[0] = static_cast<Word>(static_cast<Word>(slot) << (WORD_BITS - STRIDE_BITS));
+
+            // Resolve every prefix up to STRIDE_BITS long and remember where the deeper search starts.
+            Stride_Entry& entry = stride_table_[slot];
+            std::uint32_t index = root_;
+            while (index != NONE) {
+                const Node& node = nodes_[index];
+                if (node.length > STRIDE_BITS) {
+                    if (common_prefix(node.key, key, STRIDE_BITS) == STRIDE_BITS) {
+                        entry.node = index;
+                    }
+                    break;
+                }
+                if (common_prefix(node.key, key, node.length) != node.length) {
+                    break;
+                }
+                if (node.action != Acl_Action::None) {
+                    entry.action = node.action;
+                }
+                if (node.length == STRIDE_BITS) {
+                    // The slot key holds no bits past the stride, so the lookup picks the child by the real key.
+                    entry.node = index;
+                    break;
+                }
+                index = node.children[bit(key, node.length)];
+            }
+        }
+    }
+
+    /*
+     * Finds the action of the longest prefix containing the key.
+     *
+     * @param[in] key: The address to look up.
+     * @return The action of the longest matching prefix, or `Acl_Action::None` if no prefix matches.
+     */
+    Acl_Action lookup(const Key& key) const {
+        Acl_Action result = Acl_Action::None;
+        std::uint32_t index = root_;
+
+        if (!stride_table_.empty()) {
+            const Stride_Entry& entry = stride_table_[static_cast<std::size_t>(key[0] >> (WORD_BITS - STRIDE_BITS))];
+            result = entry.action;
+            index = entry.node;
+        }
+
+        while (index != NONE) {
+            const Node& node = nodes_[index];
+            if (common_prefix(node.key, key, node.length) != node.length) {
+                break;
+            }
+            if (node.action != Acl_Action::None) {
+                result = node.action;
+            }
+            if (node.length == MAX_BITS) {
+                break;
+            }
+            index = node.children[bit(key, node.length)];
+        }
+        return result;
+    }
+
+    /*
+     * Get the number of nodes in the trie.
+     *
+     * @return The number of nodes.
+     */
+    std::size_t size() const {
+        return nodes_.size();
+    }
+
+private:
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    // Number of leading key bits resolved by the first-level table.
+    static constexpr unsigned STRIDE_BITS = 16;
+
+    struct Stride_Entry {
+        std::uint32_t node;  // Node the deeper search starts from: the slot's STRIDE_BITS node, or the first longer one.
+        Acl_Action action;   // Action of the longest prefix of at most STRIDE_BITS bits.
+    };
+
+    struct Node {
+        Key key;
+        std::uint8_t length;
+        Acl_Action action;
+        std::uint32_t children[2];
+    };
+
+    std::uint32_t add_node(const Key& key, unsigned length, Acl_Action action) {
+        nodes_.push_back({ key, static_cast<std::uint8_t>(length), action, { NONE, NONE } });
+        return static_cast<std::uint32_t>(nodes_.size() - 1);
+    }
+
+    void set_link(std::uint32_t parent, unsigned parent_bit, std::uint32_t child) {
+        if (parent == NONE) {
+            root_ = child;
+        }
+        else {
+            nodes_[parent].children[parent_bit] = child;
+        }
+    }
+
+    static unsigned bit(const Key& key, unsigned index) {
+        return static_cast<unsigned>(key[index / WORD_BITS] >> (WORD_BITS - 1 - index % WORD_BITS)) & 1u;
+    }
+
+    // Number of leading bits shared by both keys, capped at `limit`.
+    static unsigned common_prefix(const Key& a, const Key& b, unsigned limit) {
+        for (std::size_t i = 0; i < Words; ++i) {
+            const Word difference = a[i] ^ b[i];
+            if (difference != 0) {
+                const unsigned common = static_cast<unsigned>(i * WORD_BITS + std::countl_zero(difference));
+                return common < limit ? common : limit;
+            }
+            if ((i + 1) * WORD_BITS >= limit) {
+                return limit;
+            }
+        }
+        return limit;
+    }
+
+    static Key mask(Key key, unsigned length) {
+        for (std::size_t i = 0; i < Words; ++i) {
+            const unsigned word_start = static_cast<unsigned>(i * WORD_BITS);
+            if (length <= word_start) {
+                key[i] = 0;
+            }
+            else if (length - word_start < WORD_BITS) {
+                key[i] &= static_cast<Word>(~static_cast<Word>(0) << (WORD_BITS - (length - word_start)));
+            }
+        }
+        return key;
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<Stride_Entry> stride_table_;
+    std::uint32_t root_ = NONE;
+};
@@ -55,6 +55,26 @@ void ProxyConfiguration::removeBlockedPort(int port) {
         });
 }
 
+void ProxyConfiguration::addPriorityPort(int port) {
+    priorityPorts.push_back(port); // Add the provided port number to the list of priority ports.
+}
+
+void ProxyConfiguration::removePriorityPort(int port) {
+    std::erase_if(priorityPorts, [port](int p) {
+        return p == port; // Remove port numbers matching the provided port from the list of priority ports.
+        });
+}
+
+void ProxyConfiguration::addPriorityUser(const std::string& user) {
+    priorityUsers.push_back(user); // Add the provided user name to the list of priority users.
+}
+
+void ProxyConfiguration::removePriorityUser(const std::string& user) {
+    std::erase_if(priorityUsers, [&user](const std::string& name) {
+        return name == user; // Remove user names matching the provided name from the list of priority users.
+        });
+}
+
 void ProxyConfiguration::setProxyServerIp(const std::string& ip) {
     proxyIP = ip;
 }
@@ -87,6 +107,14 @@ const std::vector<int>& ProxyConfiguration::getBlockedPorts() const {
     return blockedPorts; 
 }
 
+const std::vector<int>& ProxyConfiguration::getPriorityPorts() const {
+    return priorityPorts;
+}
+
+const std::vector<std::string>& ProxyConfiguration::getPriorityUsers() const {
+    return priorityUsers;
+}
+
 void ProxyConfiguration::setLogFilesDir(const std::string& dir) {
     logFilesDir = dir; 
 }
@@ -151,6 +179,310 @@ int ProxyConfiguration::getAuthenticationMethod() const {
     return authenticationMethod;
 }
 
+void ProxyConfiguration::setNumIoThreads(int num) {
+    numIoThreads = num;
+}
+
+int ProxyConfiguration::getNumIoThreads() const {
+    return numIoThreads;
+}
+
+void ProxyConfiguration::setCpuAffinity(bool enabled) {
+    cpuAffinity = enabled;
+}
+
+bool ProxyConfiguration::getCpuAffinity() const {
+    return cpuAffinity;
+}
+
+void ProxyConfiguration::setRelayEngine(int engine) {
+    relayEngine = engine;
+}
+
+int ProxyConfiguration::getRelayEngine() const {
+    return relayEngine;
+}
+
+void ProxyConfiguration::setDnsCacheTtl(int seconds) {
+    dnsCacheTtl = seconds;
+}
+
+int ProxyConfiguration::getDnsCacheTtl() const {
+    return dnsCacheTtl;
+}
+
+void ProxyConfiguration::setDnsNegativeCacheTtl(int seconds) {
+    dnsNegativeCacheTtl = seconds;
+}
+
+int ProxyConfiguration::getDnsNegativeCacheTtl() const {
+    return dnsNegativeCacheTtl;
+}
+
+void ProxyConfiguration::setDnsCacheMaxEntries(int entries) {
+    dnsCacheMaxEntries = entries;
+}
+
+int ProxyConfiguration::getDnsCacheMaxEntries() const {
+    return dnsCacheMaxEntries;
+}
+
+void ProxyConfiguration::setConfigHotReload(bool enabled) {
+    configHotReload = enabled;
+}
+
+bool ProxyConfiguration::getConfigHotReload() const {
+    return configHotReload;
+}
+
+void ProxyConfiguration::setLogQueueCapacity(int capacity) {
+    logQueueCapacity = capacity;
+}
+
+int ProxyConfiguration::getLogQueueCapacity() const {
+    return logQueueCapacity;
+}
+
+void ProxyConfiguration::setDbBatchSize(int size) {
+    dbBatchSize = size;
+}
+
+int ProxyConfiguration::getDbBatchSize() const {
+    return dbBatchSize;
+}
+
+void ProxyConfiguration::setDbFlushIntervalMs(int interval) {
+    dbFlushIntervalMs = interval;
+}
+
+int ProxyConfiguration::getDbFlushIntervalMs() const {
+    return dbFlushIntervalMs;
+}
+
+void ProxyConfiguration::setRelayPipelineDepth(int depth) {
+    relayPipelineDepth = depth;
+}
+
+int ProxyConfiguration::getRelayPipelineDepth() const {
+    return relayPipelineDepth;
+}
+
+void ProxyConfiguration::setRelayMinBufferSize(int size) {
+    relayMinBufferSize = size;
+}
+
+int ProxyConfiguration::getRelayMinBufferSize() const {
+    return relayMinBufferSize;
+}
+
+void ProxyConfiguration::setRelayMaxBufferSize(int size) {
+    relayMaxBufferSize = size;
+}
+
+int ProxyConfiguration::getRelayMaxBufferSize() const {
+    return relayMaxBufferSize;
+}
+
+void ProxyConfiguration::setOptimisticConnect(bool enabled) {
+    optimisticConnect = enabled;
+}
+
+bool ProxyConfiguration::getOptimisticConnect() const {
+    return optimisticConnect;
+}
+
+void ProxyConfiguration::setOptimisticBufferSize(int size) {
+    optimisticBufferSize = size;
+}
+
+int ProxyConfiguration::getOptimisticBufferSize() const {
+    return optimisticBufferSize;
+}
+
+void ProxyConfiguration::setConnectAttemptDelayMs(int delay) {
+    connectAttemptDelayMs = delay;
+}
+
+int ProxyConfiguration::getConnectAttemptDelayMs() const {
+    return connectAttemptDelayMs;
+}
+
+void ProxyConfiguration::setHandshakeTimeout(int timeout) {
+    handshakeTimeout = timeout;
+}
+
+int ProxyConfiguration::getHandshakeTimeout() const {
+    return handshakeTimeout;
+}
+
+void ProxyConfiguration::setConnectTimeout(int timeout) {
+    connectTimeout = timeout;
+}
+
+int ProxyConfiguration::getConnectTimeout() const {
+    return connectTimeout;
+}
+
+void ProxyConfiguration::setIdleTimeout(int timeout) {
+    idleTimeout = timeout;
+}
+
+int ProxyConfiguration::getIdleTimeout() const {
+    return idleTimeout;
+}
+
+void ProxyConfiguration::setTcpKeepAliveIdle(int idle) {
+    tcpKeepAliveIdle = idle;
+}
+
+int ProxyConfiguration::getTcpKeepAliveIdle() const {
+    return tcpKeepAliveIdle;
+}
+
+void ProxyConfiguration::setTcpKeepAliveInterval(int interval) {
+    tcpKeepAliveInterval = interval;
+}
+
+int ProxyConfiguration::getTcpKeepAliveInterval() const {
+    return tcpKeepAliveInterval;
+}
+
+void ProxyConfiguration::setMaxSessions(int count) {
+    maxSessions = count;
+}
+
+int ProxyConfiguration::getMaxSessions() const {
+    return maxSessions;
+}
+
+void ProxyConfiguration::setMaxSessionsPerIp(int count) {
+    maxSessionsPerIp = count;
+}
+
+int ProxyConfiguration::getMaxSessionsPerIp() const {
+    return maxSessionsPerIp;
+}
+
+void ProxyConfiguration::setAcceptRate(int rate) {
+    acceptRate = rate;
+}
+
+int ProxyConfiguration::getAcceptRate() const {
+    return acceptRate;
+}
+
+void ProxyConfiguration::setAcceptBurst(int burst) {
+    acceptBurst = burst;
+}
+
+int ProxyConfiguration::getAcceptBurst() const {
+    return acceptBurst;
+}
+
+void ProxyConfiguration::setPendingAccepts(int count) {
+    pendingAccepts = count;
+}
+
+int ProxyConfiguration::getPendingAccepts() const {
+    return pendingAccepts;
+}
+
+void ProxyConfiguration::setRejectWithReset(bool enabled) {
+    rejectWithReset = enabled;
+}
+
+bool ProxyConfiguration::getRejectWithReset() const {
+    return rejectWithReset;
+}
+
+void ProxyConfiguration::setSessionRateLimit(int rate) {
+    sessionRateLimit = rate;
+}
+
+int ProxyConfiguration::getSessionRateLimit() const {
+    return sessionRateLimit;
+}
+
+void ProxyConfiguration::setUserRateLimit(int rate) {
+    userRateLimit = rate;
+}
+
+int ProxyConfiguration::getUserRateLimit() const {
+    return userRateLimit;
+}
+
+void ProxyConfiguration::setIpRateLimit(int rate) {
+    ipRateLimit = rate;
+}
+
+int ProxyConfiguration::getIpRateLimit() const {
+    return ipRateLimit;
+}
+
+void ProxyConfiguration::setRateLimitBurst(int burst) {
+    rateLimitBurst = burst;
+}
+
+int ProxyConfiguration::getRateLimitBurst() const {
+    return rateLimitBurst;
+}
+
+void ProxyConfiguration::setRelayQuantum(int quantum) {
+    relayQuantum = quantum;
+}
+
+int ProxyConfiguration::getRelayQuantum() const {
+    return relayQuantum;
+}
+
+void ProxyConfiguration::setPriorityWeight(int weight) {
+    priorityWeight = weight;
+}
+
+int ProxyConfiguration::getPriorityWeight() const {
+    return priorityWeight;
+}
+
+void ProxyConfiguration::setRebalanceInterval(int interval) {
+    rebalanceInterval = interval;
+}
+
+int ProxyConfiguration::getRebalanceInterval() const {
+    return rebalanceInterval;
+}
+
+void ProxyConfiguration::setRebalanceThreshold(int threshold) {
+    rebalanceThreshold = threshold;
+}
+
+int ProxyConfiguration::getRebalanceThreshold() const {
+    return rebalanceThreshold;
+}
+
+void ProxyConfiguration::setRebalanceMinRate(int rate) {
+    rebalanceMinRate = rate;
+}
+
+int ProxyConfiguration::getRebalanceMinRate() const {
+    return rebalanceMinRate;
+}
+
+void ProxyConfiguration::setDrainTimeout(int timeout) {
+    drainTimeout = timeout;
+}
+
+int ProxyConfiguration::getDrainTimeout() const {
+    return drainTimeout;
+}
+
+void ProxyConfiguration::setHandoffSocket(const std::string& path) {
+    handoffSocket = path;
+}
+
+std::string ProxyConfiguration::getHandoffSocket() const {
+    return handoffSocket;
+}
+
 
 void ProxyConfiguration::saveConfigToIni(const std::string& filename) {
     try {
@@ -176,6 +508,14 @@ void ProxyConfiguration::saveConfigToIni(const std::string& filename) {
             tree.add("blockedPorts.Port" + std::to_string(i), blockedPorts[i]);
         }
 
+        // Save priority ports and users
+        for (size_t i = 0; i < priorityPorts.size(); ++i) {
+            tree.add("priorityPorts.Port" + std::to_string(i), priorityPorts[i]);
+        }
+        for (size_t i = 0; i < priorityUsers.size(); ++i) {
+            tree.add("priorityUsers.User" + std::to_string(i), priorityUsers[i]);
+        }
+
         // Save proxy server IP and port
         tree.put("proxyIP", proxyIP);
         tree.put("proxyPort", proxyPort);
@@ -189,6 +529,44 @@ void ProxyConfiguration::saveConfigToIni(const std::string& filename) {
         tree.put("numActiveThreads", numActiveThreads);
         tree.put("loggingMethod", loggingMethod);
         tree.put("authenticationMethod", authenticationMethod);
+        tree.put("numIoThreads", numIoThreads);
+        tree.put("cpuAffinity", cpuAffinity);
+        tree.put("relayEngine", relayEngine);
+        tree.put("dnsCacheTtl", dnsCacheTtl);
+        tree.put("dnsNegativeCacheTtl", dnsNegativeCacheTtl);
+        tree.put("dnsCacheMaxEntries", dnsCacheMaxEntries);
+        tree.put("configHotReload", configHotReload);
+        tree.put("logQueueCapacity", logQueueCapacity);
+        tree.put("dbBatchSize", dbBatchSize);
+        tree.put("dbFlushIntervalMs", dbFlushIntervalMs);
+        tree.put("relayPipelineDepth", relayPipelineDepth);
+        tree.put("relayMinBufferSize", relayMinBufferSize);
+        tree.put("relayMaxBufferSize", relayMaxBufferSize);
+        tree.put("optimisticConnect", optimisticConnect);
+        tree.put("optimisticBufferSize", optimisticBufferSize);
+        tree.put("connectAttemptDelayMs", connectAttemptDelayMs);
+        tree.put("handshakeTimeout", handshakeTimeout);
+        tree.put("connectTimeout", connectTimeout);
+        tree.put("idleTimeout", idleTimeout);
+        tree.put("tcpKeepAliveIdle", tcpKeepAliveIdle);
+        tree.put("tcpKeepAliveInterval", tcpKeepAliveInterval);
+        tree.put("maxSessions", maxSessions);
+        tree.put("maxSessionsPerIp", maxSessionsPerIp);
+        tree.put("acceptRate", acceptRate);
+        tree.put("acceptBurst", acceptBurst);
+        tree.put("pendingAccepts", pendingAccepts);
+        tree.put("rejectWithReset", rejectWithReset);
+        tree.put("sessionRateLimit", sessionRateLimit);
+        tree.put("userRateLimit", userRateLimit);
+        tree.put("ipRateLimit", ipRateLimit);
+        tree.put("rateLimitBurst", rateLimitBurst);
+        tree.put("relayQuantum", relayQuantum);
+        tree.put("priorityWeight", priorityWeight);
+        tree.put("rebalanceInterval", rebalanceInterval);
+        tree.put("rebalanceThreshold", rebalanceThreshold);
+        tree.put("rebalanceMinRate", rebalanceMinRate);
+        tree.put("drainTimeout", drainTimeout);
+        tree.put("handoffSocket", handoffSocket);
 
         // Write to INI file
         pt::write_ini(filename, tree);
@@ -237,6 +615,20 @@ void ProxyConfiguration::loadConfigFromIni(const std::string& filename) {
             }
         }
 
+        // Load priority ports and users
+        if (tree.get_child_optional("priorityPorts")) {
+            for (const auto& entry : tree.get_child("priorityPorts")) {
+                int port = entry.second.get_value<int>();
+                priorityPorts.push_back(port);
+            }
+        }
+        if (tree.get_child_optional("priorityUsers")) {
+            for (const auto& entry : tree.get_child("priorityUsers")) {
+                std::string user = entry.second.get_value<std::string>();
+                priorityUsers.push_back(user);
+            }
+        }
+
         // Load proxy server IP and port
         if (tree.get_optional<std::string>("proxyIP")) {
             proxyIP = tree.get<std::string>("proxyIP");
@@ -270,6 +662,120 @@ void ProxyConfiguration::loadConfigFromIni(const std::string& filename) {
         if (tree.get_optional<int>("authenticationMethod")) {
             authenticationMethod = tree.get<int>("authenticationMethod");
         }
+        if (tree.get_optional<int>("numIoThreads")) {
+            numIoThreads = tree.get<int>("numIoThreads");
+        }
+        if (tree.get_optional<bool>("cpuAffinity")) {
+            cpuAffinity = tree.get<bool>("cpuAffinity");
+        }
+        if (tree.get_optional<int>("relayEngine")) {
+            relayEngine = tree.get<int>("relayEngine");
+        }
+        if (tree.get_optional<int>("dnsCacheTtl")) {
+            dnsCacheTtl = tree.get<int>("dnsCacheTtl");
+        }
+        if (tree.get_optional<int>("dnsNegativeCacheTtl")) {
+            dnsNegativeCacheTtl = tree.get<int>("dnsNegativeCacheTtl");
+        }
+        if (tree.get_optional<int>("dnsCacheMaxEntries")) {
+            dnsCacheMaxEntries = tree.get<int>("dnsCacheMaxEntries");
+        }
+        if (tree.get_optional<bool>("configHotReload")) {
+            configHotReload = tree.get<bool>("configHotReload");
+        }
+        if (tree.get_optional<int>("logQueueCapacity")) {
+            logQueueCapacity = tree.get<int>("logQueueCapacity");
+        }
+        if (tree.get_optional<int>("dbBatchSize")) {
+            dbBatchSize = tree.get<int>("dbBatchSize");
+        }
+        if (tree.get_optional<int>("dbFlushIntervalMs")) {
+            dbFlushIntervalMs = tree.get<int>("dbFlushIntervalMs");
+        }
+        if (tree.get_optional<int>("relayPipelineDepth")) {
+            relayPipelineDepth = tree.get<int>("relayPipelineDepth");
+        }
+        if (tree.get_optional<int>("relayMinBufferSize")) {
+            relayMinBufferSize = tree.get<int>("relayMinBufferSize");
+        }
+        if (tree.get_optional<int>("relayMaxBufferSize")) {
+            relayMaxBufferSize = tree.get<int>("relayMaxBufferSize");
+        }
+        if (tree.get_optional<bool>("optimisticConnect")) {
+            optimisticConnect = tree.get<bool>("optimisticConnect");
+        }
+        if (tree.get_optional<int>("optimisticBufferSize")) {
+            optimisticBufferSize = tree.get<int>("optimisticBufferSize");
+        }
+        if (tree.get_optional<int>("connectAttemptDelayMs")) {
+            connectAttemptDelayMs = tree.get<int>("connectAttemptDelayMs");
+        }
+        if (tree.get_optional<int>("handshakeTimeout")) {
+            handshakeTimeout = tree.get<int>("handshakeTimeout");
+        }
+        if (tree.get_optional<int>("connectTimeout")) {
+            connectTimeout = tree.get<int>("connectTimeout");
+        }
+        if (tree.get_optional<int>("idleTimeout")) {
+            idleTimeout = tree.get<int>("idleTimeout");
+        }
+        if (tree.get_optional<int>("tcpKeepAliveIdle")) {
+            tcpKeepAliveIdle = tree.get<int>("tcpKeepAliveIdle");
+        }
+        if (tree.get_optional<int>("tcpKeepAliveInterval")) {
+            tcpKeepAliveInterval = tree.get<int>("tcpKeepAliveInterval");
+        }
+        if (tree.get_optional<int>("maxSessions")) {
+            maxSessions = tree.get<int>("maxSessions");
+        }
+        if (tree.get_optional<int>("maxSessionsPerIp")) {
+            maxSessionsPerIp = tree.get<int>("maxSessionsPerIp");
+        }
+        if (tree.get_optional<int>("acceptRate")) {
+            acceptRate = tree.get<int>("acceptRate");
+        }
+        if (tree.get_optional<int>("acceptBurst")) {
+            acceptBurst = tree.get<int>("acceptBurst");
+        }
+        if (tree.get_optional<int>("pendingAccepts")) {
+            pendingAccepts = tree.get<int>("pendingAccepts");
+        }
+        if (tree.get_optional<bool>("rejectWithReset")) {
+            rejectWithReset = tree.get<bool>("rejectWithReset");
+        }
+        if (tree.get_optional<int>("sessionRateLimit")) {
+            sessionRateLimit = tree.get<int>("sessionRateLimit");
+        }
+        if (tree.get_optional<int>("userRateLimit")) {
+            userRateLimit = tree.get<int>("userRateLimit");
+        }
+        if (tree.get_optional<int>("ipRateLimit")) {
+            ipRateLimit = tree.get<int>("ipRateLimit");
+        }
+        if (tree.get_optional<int>("rateLimitBurst")) {
+            rateLimitBurst = tree.get<int>("rateLimitBurst");
+        }
+        if (tree.get_optional<int>("relayQuantum")) {
+            relayQuantum = tree.get<int>("relayQuantum");
+        }
+        if (tree.get_optional<int>("priorityWeight")) {
+            priorityWeight = tree.get<int>("priorityWeight");
+        }
+        if (tree.get_optional<int>("rebalanceInterval")) {
+            rebalanceInterval = tree.get<int>("rebalanceInterval");
+        }
+        if (tree.get_optional<int>("rebalanceThreshold")) {
+            rebalanceThreshold = tree.get<int>("rebalanceThreshold");
+        }
+        if (tree.get_optional<int>("rebalanceMinRate")) {
+            rebalanceMinRate = tree.get<int>("rebalanceMinRate");
+        }
+        if (tree.get_optional<int>("drainTimeout")) {
+            drainTimeout = tree.get<int>("drainTimeout");
+        }
+        if (tree.get_optional<std::string>("handoffSocket")) {
+            handoffSocket = tree.get<std::string>("handoffSocket");
+        }
     }
     catch (const boost::wrapexcept<pt::ini_parser::ini_parser_error>& ex) {
         throw std::runtime_error("INI Parsing Error: " + std::string(ex.what()));
@@ -19,6 +19,8 @@ private:
     std::vector<std::string> blockedIPs; // List of blocked IP addresses.
     std::vector<int> allowedPorts; // List of allowed ports.
     std::vector<int> blockedPorts; // List of blocked ports.
+    std::vector<int> priorityPorts; // List of destination ports whose tunnels are scheduled with priority.
+    std::vector<std::string> priorityUsers; // List of authenticated users whose tunnels are scheduled with priority.
     std::string proxyIP; // IP address of the proxy server.
     int proxyPort; // Port number of the proxy server.
     std::string logFilesDir; // Directory for log files.
@@ -29,6 +31,44 @@ private:
     int numActiveThreads; // Number of active threads for logger.
     int loggingMethod;    // Logging method with int input/output.
     int authenticationMethod; // Authentication method.
+    int numIoThreads = 1; // Number of io_context reactor threads (0 - one per hardware core).
+    bool cpuAffinity = false; // Pin each reactor thread to its own CPU core.
+    int relayEngine = 0; // Relay engine for established tunnels (0 - copy, 1 - splice where available, 2 - io_uring where available).
+    int dnsCacheTtl = 60; // Time in seconds resolved host names are cached for.
+    int dnsNegativeCacheTtl = 5; // Time in seconds failed host name lookups are cached for.
+    int dnsCacheMaxEntries = 10000; // Maximum number of host names kept in the DNS cache.
+    bool configHotReload = true; // Reload the policy when the configuration file changes.
+    int logQueueCapacity = 65536; // Number of entries the logger and database queues can hold before new entries are dropped.
+    int dbBatchSize = 4096; // Maximum number of log entries committed to the database in one transaction.
+    int dbFlushIntervalMs = 100; // Maximum time in milliseconds a log entry waits before its transaction is committed.
+    int relayPipelineDepth = 2; // Number of buffers per direction the copy relay may fill ahead of the writes (1 - no pipelining).
+    int relayMinBufferSize = 4096; // Smallest relay buffer in bytes, used by new and idle flows.
+    int relayMaxBufferSize = 262144; // Largest relay buffer in bytes, reached by bulk transfers.
+    bool optimisticConnect = false; // Reply success to CONNECT requests before the target is connected.
+    int optimisticBufferSize = 65536; // Client data in bytes buffered while an optimistic connect is in flight.
+    int connectAttemptDelayMs = 250; // Time in milliseconds a connection attempt gets before the next address is tried alongside it.
+    int handshakeTimeout = 10; // Time in seconds a client gets to complete the handshake (0 - no timeout).
+    int connectTimeout = 10; // Time in seconds connecting to a target may take, including the lookup (0 - no timeout).
+    int idleTimeout = 300; // Time in seconds a tunnel may relay nothing before it is closed (0 - no timeout).
+    int tcpKeepAliveIdle = 60; // Time in seconds a connection is idle before TCP keepalive probes are sent (0 - no keepalive).
+    int tcpKeepAliveInterval = 10; // Time in seconds between TCP keepalive probes.
+    int maxSessions = 0; // Maximum number of concurrent sessions (0 - no limit).
+    int maxSessionsPerIp = 0; // Maximum number of concurrent sessions of one client IP address (0 - no limit).
+    int acceptRate = 0; // Connections accepted per second, with bursts up to acceptBurst (0 - no limit).
+    int acceptBurst = 64; // Connections accepted at once after a quiet period when acceptRate is set.
+    int pendingAccepts = 4; // Accepts kept outstanding on every listening socket.
+    bool rejectWithReset = false; // Reject connections over the limits with a TCP reset instead of a SOCKS failure reply.
+    int sessionRateLimit = 0; // Bytes per second a session may relay in both directions together (0 - no limit).
+    int userRateLimit = 0; // Bytes per second the sessions of one authenticated user may relay together (0 - no limit).
+    int ipRateLimit = 0; // Bytes per second the sessions of one client IP address may relay together (0 - no limit).
+    int rateLimitBurst = 262144; // Bytes a rate limited session, user or client IP address may relay at once after a quiet period.
+    int relayQuantum = 65536; // Bytes a tunnel direction may relay per scheduling round before the other ready sessions get their turn (0 - no limit).
+    int priorityWeight = 4; // Scheduling rounds of tunnels to priority ports or of priority users are this many times larger.
+    int rebalanceInterval = 1000; // Time in milliseconds between load samples of the reactor threads, after which an idle thread may take over a heavy tunnel from a busy one (0 - no rebalancing).
+    int rebalanceThreshold = 20; // Difference in percent of busy time between two reactor threads above which the idle one takes over a tunnel.
+    int rebalanceMinRate = 1048576; // Bytes per second a tunnel must relay to be moved to another reactor thread.
+    int drainTimeout = 30; // Time in seconds existing tunnels get to finish when the server stops or hands its listening sockets over (0 - close at once).
+    std::string handoffSocket; // Path of the Unix socket a new process takes the listening sockets over from on Linux (empty - no handoff).
 
 public:
     /*
@@ -87,6 +127,34 @@ public:
      */
     void removeBlockedPort(int port);
 
+    /*
+     * Add a port number to the list of priority ports.
+     *
+     * @param[in] port: The destination port number to be added to the priority list.
+     */
+    void addPriorityPort(int port);
+
+    /*
+     * Remove a port number from the list of priority ports.
+     *
+     * @param[in] port: The destination port number to be removed from the priority list.
+     */
+    void removePriorityPort(int port);
+
+    /*
+     * Add a user to the list of priority users.
+     *
+     * @param[in] user: The user name to be added to the priority list.
+     */
+    void addPriorityUser(const std::string& user);
+
+    /*
+     * Remove a user from the list of priority users.
+     *
+     * @param[in] user: The user name to be removed from the priority list.
+     */
+    void removePriorityUser(const std::string& user);
+
     /*
      * Set the IP address of the proxy server.
      *
@@ -143,6 +211,20 @@ public:
      */
     const std::vector<int>& getBlockedPorts() const;
 
+    /*
+     * Get a reference to the list of priority ports.
+     *
+     * @return A reference to the list of priority ports.
+     */
+    const std::vector<int>& getPriorityPorts() const;
+
+    /*
+     * Get a reference to the list of priority users.
+     *
+     * @return A reference to the list of priority users.
+     */
+    const std::vector<std::string>& getPriorityUsers() const;
+
     /*
      * Set the directory for log files.
      *
@@ -255,6 +337,538 @@ public:
      */
     int getAuthenticationMethod() const;
 
+    /**
+     * Set the number of io_context reactor threads.
+     *
+     * @param[in] num: The number of reactor threads (0 - one per hardware core).
+     */
+    void setNumIoThreads(int num);
+
+    /**
+     * Get the number of io_context reactor threads.
+     *
+     * @return The number of reactor threads (0 - one per hardware core).
+     */
+    int getNumIoThreads() const;
+
+    /**
+     * Enable or disable pinning reactor threads to CPU cores.
+     *
+     * @param[in] enabled: True to pin each reactor thread to its own core.
+     */
+    void setCpuAffinity(bool enabled);
+
+    /**
+     * Check whether reactor threads are pinned to CPU cores.
+     *
+     * @return True if each reactor thread is pinned to its own core.
+     */
+    bool getCpuAffinity() const;
+
+    /**
+     * Set the relay engine used for established tunnels.
+     *
+     * @param[in] engine: The relay engine (0 - copy, 1 - splice where available).
+     */
+    void setRelayEngine(int engine);
+
+    /**
+     * Get the relay engine used for established tunnels.
+     *
+     * @return The relay engine (0 - copy, 1 - splice where available).
+     */
+    int getRelayEngine() const;
+
+    /**
+     * Set the time resolved host names are cached for.
+     *
+     * @param[in] seconds: The time in seconds.
+     */
+    void setDnsCacheTtl(int seconds);
+
+    /**
+     * Get the time resolved host names are cached for.
+     *
+     * @return The time in seconds.
+     */
+    int getDnsCacheTtl() const;
+
+    /**
+     * Set the time failed host name lookups are cached for.
+     *
+     * @param[in] seconds: The time in seconds.
+     */
+    void setDnsNegativeCacheTtl(int seconds);
+
+    /**
+     * Get the time failed host name lookups are cached for.
+     *
+     * @return The time in seconds.
+     */
+    int getDnsNegativeCacheTtl() const;
+
+    /**
+     * Set the maximum number of host names kept in the DNS cache.
+     *
+     * @param[in] entries: The maximum number of cached host names.
+     */
+    void setDnsCacheMaxEntries(int entries);
+
+    /**
+     * Get the maximum number of host names kept in the DNS cache.
+     *
+     * @return The maximum number of cached host names.
+     */
+    int getDnsCacheMaxEntries() const;
+
+    /**
+     * Set whether the policy is reloaded when the configuration file changes.
+     *
+     * @param[in] enabled: True to watch the configuration file.
+     */
+    void setConfigHotReload(bool enabled);
+
+    /**
+     * Get whether the policy is reloaded when the configuration file changes.
+     *
+     * @return True to watch the configuration file.
+     */
+    bool getConfigHotReload() const;
+
+    /**
+     * Set the number of entries the logger and database queues can hold.
+     *
+     * @param[in] capacity: The queue capacity.
+     */
+    void setLogQueueCapacity(int capacity);
+
+    /**
+     * Get the number of entries the logger and database queues can hold.
+     *
+     * @return The queue capacity.
+     */
+    int getLogQueueCapacity() const;
+
+    /**
+     * Set the maximum number of log entries committed to the database in one transaction.
+     *
+     * @param[in] size: The maximum number of entries per transaction.
+     */
+    void setDbBatchSize(int size);
+
+    /**
+     * Get the maximum number of log entries committed to the database in one transaction.
+     *
+     * @return The maximum number of entries per transaction.
+     */
+    int getDbBatchSize() const;
+
+    /**
+     * Set the maximum time a log entry waits before its transaction is committed.
+     *
+     * @param[in] interval: The interval in milliseconds.
+     */
+    void setDbFlushIntervalMs(int interval);
+
+    /**
+     * Get the maximum time a log entry waits before its transaction is committed.
+     *
+     * @return The interval in milliseconds.
+     */
+    int getDbFlushIntervalMs() const;
+
+    /**
+     * Set the number of buffers per direction the copy relay may fill ahead of the writes.
+     *
+     * @param[in] depth: The pipeline depth.
+     */
+    void setRelayPipelineDepth(int depth);
+
+    /**
+     * Get the number of buffers per direction the copy relay may fill ahead of the writes.
+     *
+     * @return The pipeline depth.
+     */
+    int getRelayPipelineDepth() const;
+
+    /**
+     * Set the smallest relay buffer size.
+     *
+     * @param[in] size: The size in bytes.
+     */
+    void setRelayMinBufferSize(int size);
+
+    /**
+     * Get the smallest relay buffer size.
+     *
+     * @return The size in bytes.
+     */
+    int getRelayMinBufferSize() const;
+
+    /**
+     * Set the largest relay buffer size.
+     *
+     * @param[in] size: The size in bytes.
+     */
+    void setRelayMaxBufferSize(int size);
+
+    /**
+     * Get the largest relay buffer size.
+     *
+     * @return The size in bytes.
+     */
+    int getRelayMaxBufferSize() const;
+
+    /**
+     * Set whether CONNECT requests are answered before the target is connected.
+     *
+     * @param[in] enabled: True to reply optimistically.
+     */
+    void setOptimisticConnect(bool enabled);
+
+    /**
+     * Get whether CONNECT requests are answered before the target is connected.
+     *
+     * @return True if replies are optimistic.
+     */
+    bool getOptimisticConnect() const;
+
+    /**
+     * Set the amount of client data buffered while an optimistic connect is in flight.
+     *
+     * @param[in] size: The size in bytes.
+     */
+    void setOptimisticBufferSize(int size);
+
+    /**
+     * Get the amount of client data buffered while an optimistic connect is in flight.
+     *
+     * @return The size in bytes.
+     */
+    int getOptimisticBufferSize() const;
+
+    /**
+     * Set the time a connection attempt gets before the next address of the target is tried alongside it.
+     *
+     * @param[in] delay: The delay in milliseconds.
+     */
+    void setConnectAttemptDelayMs(int delay);
+
+    /**
+     * Get the time a connection attempt gets before the next address of the target is tried alongside it.
+     *
+     * @return The delay in milliseconds.
+     */
+    int getConnectAttemptDelayMs() const;
+
+    /**
+     * Set the time a client gets to complete the handshake.
+     *
+     * @param[in] timeout: The timeout in seconds.
+     */
+    void setHandshakeTimeout(int timeout);
+
+    /**
+     * Get the time a client gets to complete the handshake.
+     *
+     * @return The timeout in seconds.
+     */
+    int getHandshakeTimeout() const;
+
+    /**
+     * Set the time connecting to a target may take.
+     *
+     * @param[in] timeout: The timeout in seconds.
+     */
+    void setConnectTimeout(int timeout);
+
+    /**
+     * Get the time connecting to a target may take.
+     *
+     * @return The timeout in seconds.
+     */
+    int getConnectTimeout() const;
+
+    /**
+     * Set the time a tunnel may relay nothing before it is closed.
+     *
+     * @param[in] timeout: The timeout in seconds.
+     */
+    void setIdleTimeout(int timeout);
+
+    /**
+     * Get the time a tunnel may relay nothing before it is closed.
+     *
+     * @return The timeout in seconds.
+     */
+    int getIdleTimeout() const;
+
+    /**
+     * Set the time a connection is idle before TCP keepalive probes are sent.
+     *
+     * @param[in] idle: The time in seconds.
+     */
+    void setTcpKeepAliveIdle(int idle);
+
+    /**
+     * Get the time a connection is idle before TCP keepalive probes are sent.
+     *
+     * @return The time in seconds.
+     */
+    int getTcpKeepAliveIdle() const;
+
+    /**
+     * Set the time between TCP keepalive probes.
+     *
+     * @param[in] interval: The time in seconds.
+     */
+    void setTcpKeepAliveInterval(int interval);
+
+    /**
+     * Get the time between TCP keepalive probes.
+     *
+     * @return The time in seconds.
+     */
+    int getTcpKeepAliveInterval() const;
+
+    /**
+     * Set the maximum number of concurrent sessions.
+     *
+     * @param[in] count: The number of sessions, 0 for no limit.
+     */
+    void setMaxSessions(int count);
+
+    /**
+     * Get the maximum number of concurrent sessions.
+     *
+     * @return The number of sessions, 0 for no limit.
+     */
+    int getMaxSessions() const;
+
+    /**
+     * Set the maximum number of concurrent sessions of one client IP address.
+     *
+     * @param[in] count: The number of sessions, 0 for no limit.
+     */
+    void setMaxSessionsPerIp(int count);
+
+    /**
+     * Get the maximum number of concurrent sessions of one client IP address.
+     *
+     * @return The number of sessions, 0 for no limit.
+     */
+    int getMaxSessionsPerIp() const;
+
+    /**
+     * Set the number of connections accepted per second.
+     *
+     * @param[in] rate: The number of connections per second, 0 for no limit.
+     */
+    void setAcceptRate(int rate);
+
+    /**
+     * Get the number of connections accepted per second.
+     *
+     * @return The number of connections per second, 0 for no limit.
+     */
+    int getAcceptRate() const;
+
+    /**
+     * Set the number of connections accepted at once after a quiet period.
+     *
+     * @param[in] burst: The number of connections.
+     */
+    void setAcceptBurst(int burst);
+
+    /**
+     * Get the number of connections accepted at once after a quiet period.
+     *
+     * @return The number of connections.
+     */
+    int getAcceptBurst() const;
+
+    /**
+     * Set the number of accepts kept outstanding on every listening socket.
+     *
+     * @param[in] count: The number of accepts.
+     */
+    void setPendingAccepts(int count);
+
+    /**
+     * Get the number of accepts kept outstanding on every listening socket.
+     *
+     * @return The number of accepts.
+     */
+    int getPendingAccepts() const;
+
+    /**
+     * Set whether connections over the limits are rejected with a TCP reset instead of a SOCKS failure reply.
+     *
+     * @param[in] enabled: True to reset the connection.
+     */
+    void setRejectWithReset(bool enabled);
+
+    /**
+     * Get whether connections over the limits are rejected with a TCP reset instead of a SOCKS failure reply.
+     *
+     * @return True if rejected connections are reset.
+     */
+    bool getRejectWithReset() const;
+
+    /**
+     * Set the bytes per second a session may relay.
+     *
+     * @param[in] rate: The rate in bytes per second, 0 for no limit.
+     */
+    void setSessionRateLimit(int rate);
+
+    /**
+     * Get the bytes per second a session may relay.
+     *
+     * @return The rate in bytes per second, 0 for no limit.
+     */
+    int getSessionRateLimit() const;
+
+    /**
+     * Set the bytes per second the sessions of one authenticated user may relay together.
+     *
+     * @param[in] rate: The rate in bytes per second, 0 for no limit.
+     */
+    void setUserRateLimit(int rate);
+
+    /**
+     * Get the bytes per second the sessions of one authenticated user may relay together.
+     *
+     * @return The rate in bytes per second, 0 for no limit.
+     */
+    int getUserRateLimit() const;
+
+    /**
+     * Set the bytes per second the sessions of one client IP address may relay together.
+     *
+     * @param[in] rate: The rate in bytes per second, 0 for no limit.
+     */
+    void setIpRateLimit(int rate);
+
+    /**
+     * Get the bytes per second the sessions of one client IP address may relay together.
+     *
+     * @return The rate in bytes per second, 0 for no limit.
+     */
+    int getIpRateLimit() const;
+
+    /**
+     * Set the bytes a rate limited session, user or client IP address may relay at once after a quiet period.
+     *
+     * @param[in] burst: The burst size in bytes.
+     */
+    void setRateLimitBurst(int burst);
+
+    /**
+     * Get the bytes a rate limited session, user or client IP address may relay at once after a quiet period.
+     *
+     * @return The burst size in bytes.
+     */
+    int getRateLimitBurst() const;
+
+    /**
+     * Set the bytes a tunnel direction may relay per scheduling round.
+     *
+     * @param[in] quantum: The quantum in bytes (0 - no limit).
+     */
+    void setRelayQuantum(int quantum);
+
+    /**
+     * Get the bytes a tunnel direction may relay per scheduling round.
+     *
+     * @return The quantum in bytes (0 - no limit).
+     */
+    int getRelayQuantum() const;
+
+    /**
+     * Set the factor by which the scheduling round of a priority tunnel is larger.
+     *
+     * @param[in] weight: The factor.
+     */
+    void setPriorityWeight(int weight);
+
+    /**
+     * Get the factor by which the scheduling round of a priority tunnel is larger.
+     *
+     * @return The factor.
+     */
+    int getPriorityWeight() const;
+
+    /**
+     * Set the time between load samples of the reactor threads.
+     *
+     * @param[in] interval: The interval in milliseconds (0 - no rebalancing).
+     */
+    void setRebalanceInterval(int interval);
+
+    /**
+     * Get the time between load samples of the reactor threads.
+     *
+     * @return The interval in milliseconds (0 - no rebalancing).
+     */
+    int getRebalanceInterval() const;
+
+    /**
+     * Set the difference in busy time between two reactor threads above which a tunnel is moved.
+     *
+     * @param[in] threshold: The difference in percent.
+     */
+    void setRebalanceThreshold(int threshold);
+
+    /**
+     * Get the difference in busy time between two reactor threads above which a tunnel is moved.
+     *
+     * @return The difference in percent.
+     */
+    int getRebalanceThreshold() const;
+
+    /**
+     * Set the bytes per second a tunnel must relay to be moved to another reactor thread.
+     *
+     * @param[in] rate: The rate in bytes per second.
+     */
+    void setRebalanceMinRate(int rate);
+
+    /**
+     * Get the bytes per second a tunnel must relay to be moved to another reactor thread.
+     *
+     * @return The rate in bytes per second.
+     */
+    int getRebalanceMinRate() const;
+
+    /**
+     * Set the time in seconds existing tunnels get to finish when the server stops.
+     *
+     * @param[in] timeout: The time in seconds.
+     */
+    void setDrainTimeout(int timeout);
+
+    /**
+     * Get the time in seconds existing tunnels get to finish when the server stops.
+     *
+     * @return The time in seconds.
+     */
+    int getDrainTimeout() const;
+
+    /**
+     * Set the path of the Unix socket the listening sockets are handed over on.
+     *
+     * @param[in] path: The path, empty if there is no handoff.
+     */
+    void setHandoffSocket(const std::string& path);
+
+    /**
+     * Get the path of the Unix socket the listening sockets are handed over on.
+     *
+     * @return The path, empty if there is no handoff.
+     */
+    std::string getHandoffSocket() const;
+
     /*
      * Save the current configuration to an INI file.
      *
@@ -1,395 +1,1102 @@
 #include "ProxyServer.h"
+#include "Metrics.h"
+
+#ifdef SO_REUSEPORT
+// Lets several acceptors bind the same endpoint, with the kernel balancing connections between them.
+using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+#ifdef TCP_KEEPIDLE
+// Per-socket keepalive timing; without them the system-wide defaults apply, which wait two hours before the first probe.
+using keep_alive_idle = boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPIDLE>;
+using keep_alive_interval = boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPINTVL>;
+using keep_alive_count = boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPCNT>;
+#endif
+
+namespace {
+    // Factor a direction's buffer grows by after a read that filled it.
+    const std::size_t BUFFER_GROWTH_FACTOR = 4;
+
+    // Number of consecutive reads using less than a quarter of the buffer after which it is halved.
+    const unsigned SHRINK_AFTER_SMALL_READS = 4;
+
+    // Number of unanswered keepalive probes after which the kernel drops a connection.
+    const int KEEP_ALIVE_PROBE_COUNT = 3;
+
+    // Time an acceptor that ran out of file descriptors waits for sessions to close before accepting again.
+    const std::chrono::milliseconds ACCEPT_PAUSE(100);
+
+    // Method selection reply of a rejected connection: no acceptable methods (RFC 1928).
+    const unsigned char NO_ACCEPTABLE_METHODS = 0xFF;
+
+    // Longest a rate limited direction sleeps before checking its budget again, so a closed session does not linger.
+    const std::chrono::milliseconds MAX_SHAPING_PAUSE(100);
+
+    // Time a tunnel stays on the shard it was moved to, so it does not bounce between two shards of similar load.
+    const std::chrono::seconds MIGRATION_COOLDOWN(10);
+
+    // Time between load samples while rebalancing is disabled, so enabling it by a reload takes effect.
+    const std::chrono::milliseconds IDLE_REBALANCE_INTERVAL(1000);
+
+    // Time between checks of a draining shard for sessions that are still open.
+    const std::chrono::milliseconds DRAIN_POLL_INTERVAL(100);
+
+    // Completion token of the session's operations: the coroutine resumes with the error stored in `error`,
+    // and the operation's handler is allocated from the thread's BufferPool.
+    auto session_token(boost::system::error_code& error) {
+        return recycling(boost::asio::redirect_error(boost::asio::use_awaitable, error));
+    }
+
+    // Enables TCP keepalive on a socket, so a peer that vanished without closing is noticed even while the tunnel is idle.
+    void enable_keep_alive(boost::asio::ip::tcp::socket& socket, const Policy& policy) {
+        if (policy.keep_alive_idle().count() == 0) {
+            return;
+        }
+
+        // Failures are ignored: the idle timeout still ends the session.
+        boost::system::error_code ignored;
+        socket.set_option(boost::asio::socket_base::keep_alive(true), ignored);
+#ifdef TCP_KEEPIDLE
+        socket.set_option(keep_alive_idle(static_cast<int>(policy.keep_alive_idle().count())), ignored);
+        socket.set_option(keep_alive_interval(static_cast<int>(policy.keep_alive_interval().count())), ignored);
+        socket.set_option(keep_alive_count(KEEP_ALIVE_PROBE_COUNT), ignored);
+#endif
+    }
+
+    // CPU time the calling thread has used, in user and kernel mode.
+    std::chrono::nanoseconds thread_cpu_time() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+            return std::chrono::nanoseconds::zero();
+        }
+        // Both times count 100 ns intervals.
+        const std::uint64_t ticks = ((static_cast<std::uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime)
+            + ((static_cast<std::uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+        return std::chrono::nanoseconds(ticks * 100);
+#else
+        timespec time{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif
+    }
+}
+
+ProxyServer::Shard::Shard(boost::asio::io_context& io_context)
+    : io_context(io_context),
+    acceptor(io_context),
+    timeouts(io_context),
+    accept_timer(io_context),
+    rebalance_timer(io_context) {
+}
 
 ProxyServer::ProxyServer(boost::asio::io_context& io_context, const std::string& ip_address, unsigned short port, const ProxyConfiguration& config, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database)
-    : acceptor_(io_context),
-    socket_(std::make_shared<boost::asio::ip::tcp::socket>(acceptor_.get_executor())),
-    proxyConfig_(config),
+    : next_shard_(0),
+    acceptor_count_(1),
+    logging_method_(logging_method),
+    logger_(logger),
+    database_(database),
+    dns_cache_(std::make_shared<DnsCache>(std::chrono::seconds(config.getDnsCacheTtl()), std::chrono::seconds(config.getDnsNegativeCacheTtl()), static_cast<std::size_t>(config.getDnsCacheMaxEntries()))),
+    shaper_(std::make_shared<BandwidthShaper>()) {
+
+    update_policy(std::make_shared<const Policy>(config));
+    shards_.emplace_back(std::make_unique<Shard>(io_context));
+    open_uring_relays();
+    open_acceptors(ip_address, port, config.getHandoffSocket());
+}
+
+ProxyServer::ProxyServer(IoContextPool& pool, const std::string& ip_address, unsigned short port, const ProxyConfiguration& config, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database)
+    : next_shard_(0),
+    acceptor_count_(1),
     logging_method_(logging_method),
     logger_(logger),
-    database_(database) {
+    database_(database),
+    dns_cache_(std::make_shared<DnsCache>(std::chrono::seconds(config.getDnsCacheTtl()), std::chrono::seconds(config.getDnsNegativeCacheTtl()), static_cast<std::size_t>(config.getDnsCacheMaxEntries()))),
+    shaper_(std::make_shared<BandwidthShaper>()) {
+
+    update_policy(std::make_shared<const Policy>(config));
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+        shards_.emplace_back(std::make_unique<Shard>(pool.get_io_context(i)));
+    }
+    open_uring_relays();
+    open_acceptors(ip_address, port, config.getHandoffSocket());
+
+    // Tunnels stay on the shard that accepted them unless an idle shard takes a heavy one over.
+    if (shards_.size() > 1) {
+        for (auto& shard : shards_) {
+            shard->sampled_at = std::chrono::steady_clock::now();
+            schedule_rebalance(*shard);
+        }
+    }
+}
+
+void ProxyServer::update_policy(std::shared_ptr<const Policy> policy) {
+    if (policy->acl().invalid_entries() != 0) {
+        std::cerr << "Ignored " << policy->acl().invalid_entries() << " malformed destination rules in the configuration." << std::endl;
+    }
+    const bool uring_engine = policy->relay_engine() == 2;
+    policy_.store(std::move(policy));
+
+    // A reload that selects io_uring opens the rings the shards do not have yet, each on its own reactor thread.
+    if (uring_engine) {
+        for (auto& shard : shards_) {
+            boost::asio::post(shard->io_context, [&shard = *shard] {
+                if (shard.uring_relay) {
+                    return;
+                }
+                auto relay = std::make_unique<UringRelay>(shard.io_context);
+                if (relay->open()) {
+                    shard.uring_relay = std::move(relay);
+                }
+                else {
+                    std::cerr << "io_uring is unavailable, tunnels are relayed by copying." << std::endl;
+                }
+            });
+        }
+    }
+}
+
+std::shared_ptr<const Policy> ProxyServer::get_policy() const {
+    return policy_.load();
+}
+
+std::size_t ProxyServer::session_count() const {
+    std::size_t count = 0;
+    for (const auto& shard : shards_) {
+        count += shard->sessions.size();
+    }
+    return count;
+}
+
+void ProxyServer::open_uring_relays() {
+    if (policy_.load()->relay_engine() != 2) {
+        return;
+    }
+
+    for (auto& shard : shards_) {
+        shard->uring_relay = std::make_unique<UringRelay>(shard->io_context);
+        if (!shard->uring_relay->open()) {
+            std::cerr << "io_uring is unavailable, tunnels are relayed by copying." << std::endl;
+            for (auto& opened : shards_) {
+                opened->uring_relay.reset();
+            }
+            return;
+        }
+    }
+}
 
+void ProxyServer::open_acceptors(const std::string& ip_address, unsigned short port, const std::string& handoff_path) {
     boost::asio::ip::address_v4 custom_ip_address = boost::asio::ip::make_address_v4(ip_address);
     boost::asio::ip::tcp::endpoint endpoint(custom_ip_address, port);
-    acceptor_.open(endpoint.protocol());
-    acceptor_.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-    acceptor_.bind(endpoint);
-    acceptor_.listen();
 
-    start_accept(socket_);
+#ifdef SO_REUSEPORT
+    std::size_t acceptor_count = shards_.size();
+#else
+    std::size_t acceptor_count = 1;
+#endif
+
+    // Sockets taken over from a running process keep their backlog, so no connection is refused during an upgrade.
+    handoff_ = std::make_unique<ListenerHandoff>(shards_[0]->io_context);
+    std::size_t adopted = 0;
+    std::vector<std::pair<Shard*, boost::asio::ip::tcp::acceptor>> retired;
+    for (ListenerHandoff::Native_Handle socket : handoff_->take(handoff_path)) {
+        boost::system::error_code error;
+        Shard& shard = *shards_[adopted < acceptor_count ? adopted : 0];
+        boost::asio::ip::tcp::acceptor listener(shard.io_context);
+        listener.assign(endpoint.protocol(), socket, error);
+        if (error) {
+            continue;
+        }
+        if (listener.local_endpoint(error) != endpoint || error) {
+            // A socket of an endpoint that is no longer configured is closed once the connections waiting in it are served.
+            retired.emplace_back(&shard, std::move(listener));
+        }
+        else if (adopted < acceptor_count) {
+            shard.acceptor = std::move(listener);
+            ++adopted;
+        }
+        else {
+            // Sockets beyond one per shard stay in the kernel's SO_REUSEPORT group, which keeps handing them connections
+            // for as long as they are open, so the first shard accepts on them too.
+            shard.surplus_acceptors.push_back(std::make_unique<boost::asio::ip::tcp::acceptor>(std::move(listener)));
+        }
+    }
+#ifdef SO_REUSEPORT
+    if (adopted > 0 && adopted < acceptor_count) {
+        // Further sockets can only join the inherited ones if those share the port; otherwise the first one serves every shard.
+        reuse_port shared;
+        boost::system::error_code error;
+        shards_[0]->acceptor.get_option(shared, error);
+        if (error || !shared.value()) {
+            acceptor_count = 1;
+        }
+    }
+#endif
+
+    for (std::size_t i = adopted; i < acceptor_count; ++i) {
+        boost::asio::ip::tcp::acceptor& acceptor = shards_[i]->acceptor;
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+        if (acceptor_count > 1) {
+            acceptor.set_option(reuse_port(true));
+        }
+#endif
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    }
+
+    // Several accepts are kept outstanding, so a burst of connections is taken in one wakeup.
+    acceptor_count_ = acceptor_count;
+    const std::size_t pending_accepts = policy_.load()->pending_accepts();
+    for (std::size_t i = 0; i < acceptor_count; ++i) {
+        for (std::size_t j = 0; j < pending_accepts; ++j) {
+            start_accept(*shards_[i], shards_[i]->acceptor);
+        }
+    }
+    for (auto& surplus : shards_[0]->surplus_acceptors) {
+        for (std::size_t j = 0; j < pending_accepts; ++j) {
+            start_accept(*shards_[0], *surplus);
+        }
+    }
+
+    if (handoff_path.empty()) {
+        return;
+    }
+    // The previous process stops accepting once told, and this one drains when a successor takes over in turn.
+    handoff_->confirm();
+    for (auto& [shard, listener] : retired) {
+        boost::asio::post(shard->io_context, [this, shard = shard, listener = std::move(listener)]() mutable {
+            retire_listener(*shard, std::move(listener));
+        });
+    }
+    std::vector<ListenerHandoff::Native_Handle> listeners;
+    for (std::size_t i = 0; i < acceptor_count; ++i) {
+        listeners.push_back(shards_[i]->acceptor.native_handle());
+    }
+    for (auto& surplus : shards_[0]->surplus_acceptors) {
+        listeners.push_back(surplus->native_handle());
+    }
+    if (!handoff_->offer(handoff_path, listeners, [this] { drain(policy_.load()->drain_timeout(), handoff_handler_); })) {
+        std::cerr << "Unable to listen for a successor on " << handoff_path << ", the listening sockets cannot be handed over." << std::endl;
+    }
 }
 
 void ProxyServer::stop()
 {
-    if (acceptor_.is_open())
+    boost::asio::post(shards_[0]->io_context, [this] {
+        handoff_->close();
+    });
+    for (auto& shard : shards_)
     {
-        acceptor_.close();
-	}
+        boost::asio::post(shard->io_context, [this, &shard = *shard] {
+            stop_accepting(shard);
+            shard.stopped = true;
 
-    if (socket_ && socket_->is_open())
-    {
-        socket_->close();
+            shard.sessions.for_each([](ProxySession& session) {
+                session.close();
+            });
+        });
     }
+}
 
-    for (auto& session : active_sessions_)
-    {
-        session->close();
+void ProxyServer::drain(std::chrono::seconds timeout, std::function<void()> drained) {
+    auto state = std::make_shared<Drain>();
+    state->pending_shards = shards_.size();
+    state->deadline = std::chrono::steady_clock::now() + timeout;
+    state->drained = std::move(drained);
+
+    boost::asio::post(shards_[0]->io_context, [this] {
+        handoff_->close();
+    });
+    for (auto& shard : shards_) {
+        boost::asio::post(shard->io_context, [this, &shard = *shard, state] {
+            stop_accepting(shard);
+            await_drain(shard, state);
+        });
     }
 }
 
-ProxyServer::ProxySession::ProxySession(boost::asio::ip::tcp::socket socket, const ProxyConfiguration& config, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database)
+void ProxyServer::set_handoff_handler(std::function<void()> handler) {
+    handoff_handler_ = std::move(handler);
+}
+
+ProxyServer::ProxySession::ProxySession(boost::asio::ip::tcp::socket socket, const std::shared_ptr<const Policy> policy, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database, const std::shared_ptr<DnsCache> dns_cache, const std::shared_ptr<BandwidthShaper> shaper, Shard& shard, AdmissionControl::Ticket admission)
     : client_socket_(std::move(socket)),
     server_socket_(client_socket_.get_executor()),
-    proxyConfig_(config),
+    reply_data_(),
+    policy_(policy),
     logging_method_(logging_method),
     logger_(logger),
-    database_(database) {
-    memset(client_data_, 0, BUFFER_SIZE);
-    memset(server_data_, 0, BUFFER_SIZE);
+    database_(database),
+    dns_cache_(dns_cache),
+    shaper_(shaper),
+    relay_quantum_(0),
+    shard_(&shard),
+    uring_tunnel_(0),
+    uring_activity_(0),
+    timeout_phase_(""),
+    client_state_(Relay_State::Idle),
+    server_state_(Relay_State::Idle),
+    migration_(nullptr),
+    relayed_bytes_(0),
+    sampled_bytes_(0),
+    relay_rate_(0),
+    admission_(std::move(admission)) {
 }
 
 
 void ProxyServer::ProxySession::start() {
-    memset(client_data_, 0, BUFFER_SIZE);
-    memset(server_data_, 0, BUFFER_SIZE);
-    read_socks_request();
+    boost::system::error_code error;
+    const boost::asio::ip::tcp::endpoint client_endpoint = client_socket_.remote_endpoint(error);
+    if (error) {
+        close();
+        return;
+    }
+    client_ip_ = client_endpoint.address().to_string();
+    enable_keep_alive(client_socket_, *policy_);
+    arm_timeout(policy_->handshake_timeout(), "handshake");
+
+    // The coroutine owns the only reference to the session until the tunnel is handed to the relay.
+    boost::asio::co_spawn(client_socket_.get_executor(),
+        [self = shared_from_this()] {
+            return self->run();
+        },
+        boost::asio::detached);
 }
 
-void ProxyServer::ProxySession::read_socks_request() {
+boost::asio::awaitable<void> ProxyServer::ProxySession::run() {
     std::cout << "Reading SOCKS request from client..." << std::endl;
-    boost::system::error_code error;
-    std::size_t bytes_transferred = boost::asio::read(client_socket_, boost::asio::buffer(client_data_, 1), error);
 
-    if (!error) {
-        int version = static_cast<unsigned char>(client_data_[0]); // The socks version
+    const Authentication_Result result = co_await authenticate();
+    if (!handle_authentication(result)) {
+        close();
+        co_return;
+    }
+    username_ = result.username;
 
-        if (version != 5) {
-            send_socks_reply(5);
-            return;
-        }
+    // VER, CMD, RSV, ATYP and the first byte of DST.ADDR, which for domain names holds their length.
+    if (!co_await receive(SOCKS_REQUEST_HEADER_SIZE)) {
+        close();
+        co_return;
+    }
 
-        Handle_Authentication handle(proxyConfig_, std::move(client_socket_), BUFFER_SIZE);
-        Authentication_Result result = handle.handle_authentication();
-        const bool authenticated = result.authenticated;
-        client_socket_ = std::move(result.socket);
-        const int authentication_method = result.authentication_method;
-        const std::string error = result.error;
+    // The rest of the destination address and the port, whose size depends on the address type.
+    std::size_t remaining = 0;
+    switch (handshake_.data()[3]) {
+    case 1: // IPv4 address and port
+        remaining = 4 + 2 - 1;
+        break;
+    case 3: // Domain name and port
+        remaining = handshake_.data()[4] + 2;
+        break;
+    case 4: // IPv6 address and port
+        remaining = 16 + 2 - 1;
+        break;
+    default: // Rejected by handle_socks_request
+        break;
+    }
+    if (!co_await receive(SOCKS_REQUEST_HEADER_SIZE + remaining)) {
+        close();
+        co_return;
+    }
 
-        if (!error.empty())
-        {
-            std::cerr << "Error while authenticating: " << error << std::endl;
-            log_to_file(spdlog::level::err, client_socket_.remote_endpoint().address().to_string(), "Error while authenticating: " + error);
-            return;
+    std::string address;
+    unsigned short port = 0;
+    bool is_domain = false;
+    int status = handle_socks_request(SOCKS_REQUEST_HEADER_SIZE + remaining, address, port, is_domain);
+    handshake_.consume(SOCKS_REQUEST_HEADER_SIZE + remaining);
+    arm_timeout(policy_->connect_timeout(), "connect");
+    const bool optimistic = status == 0 && policy_->optimistic_connect();
+    if (optimistic) {
+        // The client learns the tunnel is up right away and may send while the target is being connected.
+        co_await send_socks_reply(0);
+        if (!client_socket_.is_open()) {
+            co_return;
         }
+        status = co_await connect_buffering(address, port, is_domain);
+    }
+    else if (status == 0) {
+        status = co_await connect_to_target(address, port, is_domain);
+    }
+    if (status == 0 && handshake_.size() > 0) {
+        status = co_await forward_early_data();
+    }
+    handshake_.release();
 
-        if (authenticated) {
-            std::cout << "Authenticated successfuly with method: " << authentication_method << std::endl;
-            log_to_file(spdlog::level::info, client_socket_.remote_endpoint().address().to_string(), "Authenticated successfuly with method: " + std::to_string(authentication_method));
-            memset(client_data_, 0, BUFFER_SIZE);
-            memset(server_data_, 0, BUFFER_SIZE);
-
-            // Asynchronously read the rest of the SOCKS5 request
-            client_socket_.async_read_some(
-                boost::asio::buffer(client_data_, BUFFER_SIZE),
-                [self = shared_from_this()](boost::system::error_code async_error, std::size_t async_bytes_transferred) {
-                    self->handle_socks_request(async_error, async_bytes_transferred);
-                });
-        }
-        else {
-            std::cerr << "Authentication failed." << std::endl;
-            log_to_file(spdlog::level::err, client_socket_.remote_endpoint().address().to_string(), "Authentication failed.");
-            return;
+    if (optimistic) {
+        if (status != 0 || !client_socket_.is_open()) {
+            // Success was reported already, so a failed connect can only tear the tunnel down.
+            log_to_file(spdlog::level::err, client_ip_, "Optimistic connect to " + address + " failed with status: " + std::to_string(status));
+            close();
+            co_return;
         }
     }
     else {
-        std::cerr << "Error reading initial SOCKS request: " << error.message() << std::endl;
-        log_to_file(spdlog::level::err, client_socket_.remote_endpoint().address().to_string(), "Error while reading initial SOCKS request: " + error.message());
+        co_await send_socks_reply(status);
+        if (status != 0 || !client_socket_.is_open()) {
+            // A failure reply ends the session (RFC 1928)
+            close();
+            co_return;
+        }
     }
+    forward_data(port);
 }
 
-void ProxyServer::ProxySession::handle_socks_request(const boost::system::error_code& error, std::size_t bytes_transferred) {
-    if (!error) {
-        std::cout << "Handling SOCKS5 request..." << std::endl;
-        int version = static_cast<unsigned char>(client_data_[0]); // The socks version
-        int command = static_cast<unsigned char>(client_data_[1]); // The socks command
-        int reserved = static_cast<unsigned char>(client_data_[2]); // The reserved field
-        int address_type = static_cast<unsigned char>(client_data_[3]); // The address type
-        std::cout << "bytes transferred: " << bytes_transferred << std::endl;
-        std::cout << "Received SOCKS version: " << version << std::endl;
-        std::cout << "Received SOCKS command: " << command << std::endl;
-        std::cout << "Received SOCKS reserved: " << reserved << std::endl;
-        std::cout << "Received SOCKS address type: " << address_type << std::endl;
-
-        std::string address_type_string = "";
-
-        boost::asio::ip::tcp::endpoint targetEndpoint;
-        // Check if the socks version is valid
-        if (version == SOCKS_VERSION) {
-            // Check if the socks command is connect
-            if (command == 1) {
-
-                std::string address;
-                unsigned short port;
-
-                switch (address_type) {
-                case 1: // IPv4 address
-                    std::cout << "address type is IPv4" << std::endl;
-                    address_type_string = "IPv4";
-                    if (bytes_transferred >= 10) {
-                        address = boost::asio::ip::address_v4(
-                            boost::asio::detail::socket_ops::network_to_host_long(
-                                *reinterpret_cast<unsigned long*>(client_data_ + 4)))
-                            .to_string();
-                        port = boost::asio::detail::socket_ops::network_to_host_short(
-                            *reinterpret_cast<unsigned short*>(client_data_ + 8));
-                    }
-                    else {
-                        // Send a socks reply with address type not supported
-                        boost::asio::ip::tcp::endpoint clientEndpoint = client_socket_.remote_endpoint();
-                        std::cout << "Client connected from: " << clientEndpoint.address() << ":" << clientEndpoint.port() << std::endl;
-                        send_socks_reply(8);
-                        return;
-                    }
-                    break;
-                case 3: // Domain name
-                    std::cout << "address type is domain name" << std::endl;
-                    address_type_string = "domain name";
-                    if (bytes_transferred >= 5) { // Ensure enough data for domain name length
-                        int length = client_data_[4];
-                        if (bytes_transferred >= 5 + length + 2) { // Ensure enough data for domain name and port
-                            address = std::string(client_data_ + 5, length);
-                            port = boost::asio::detail::socket_ops::network_to_host_short(
-                                *reinterpret_cast<unsigned short*>(client_data_ + 5 + length));
-                        }
-                        else {
-                            // Send a socks reply with address type not supported
-                            send_socks_reply(8);
-                            return;
-                        }
-                    }
-                    else {
-                        // Send a socks reply with address type not supported
-                        send_socks_reply(8);
-                        return;
-                    }
-                    break;
-                case 4: // IPv6 address
-                    std::cout << "address type is IPv6" << std::endl;
-                    address_type_string = "IPv6";
-                    if (bytes_transferred >= 22) {
-                        boost::asio::ip::address_v6::bytes_type ipv6_bytes;
-                        for (int i = 0; i < 16; ++i) {
-                            ipv6_bytes[i] = static_cast<unsigned char>(client_data_[i + 4]);
-                        }
-                        boost::asio::ip::address_v6 ipv6_address(ipv6_bytes);
-
-                        port = boost::asio::detail::socket_ops::network_to_host_short(
-                            *reinterpret_cast<unsigned short*>(client_data_ + 20));
-
-                        address = ipv6_address.to_string();
-                    }
-                    else {
-                        // Send a socks reply with address type not supported
-                        send_socks_reply(8);
-                        return;
-                    }
-                    break;
-                default: // Invalid address type
-                    boost::asio::ip::tcp::endpoint clientEndpoint = client_socket_.remote_endpoint();
-                    std::cout << "Client connected from: " << clientEndpoint.address() << ":" << clientEndpoint.port() << std::endl;
-                    address_type_string = clientEndpoint.address().to_string() + ":" + std::to_string(clientEndpoint.port());
-                    send_socks_reply(8);
-                    return;
-                }
+boost::asio::awaitable<Authentication_Result> ProxyServer::ProxySession::authenticate() {
+    // Greeting, method selection and sub-negotiation run asynchronously, so a stalled client never blocks the reactor.
+    co_return co_await boost::asio::async_initiate<const boost::asio::use_awaitable_t<>&, void(Authentication_Result)>(
+        [this](auto handler) {
+            // Authentication_Handler must be copyable, the coroutine's handler is move-only.
+            auto shared_handler = std::make_shared<decltype(handler)>(std::move(handler));
+            const auto handle = std::make_shared<Handle_Authentication>(policy_, client_socket_, handshake_);
+            handle->async_handle_authentication(
+                [shared_handler](const Authentication_Result& result) {
+                    (*shared_handler)(result);
+                });
+        },
+        boost::asio::use_awaitable);
+}
 
-                const std::string message = "Handling SOCKS5 request (bytes transferred: " + std::to_string(bytes_transferred) +
-                    ", version: " + std::to_string(version) +
-                    ", command: " + std::to_string(command) +
-                    ", reserved: " + std::to_string(reserved) +
-                    ", address type: " + address_type_string + ").";
-                log_to_file(spdlog::level::info, client_socket_.remote_endpoint().address().to_string(), message);
-
-                std::vector<std::string> blocked_sites = proxyConfig_.getBlockedIPs();
-                std::vector<int> blocked_ports = proxyConfig_.getBlockedPorts();
-                std::vector<std::string> allowed_sites = proxyConfig_.getAllowedIPs();
-                std::vector<int> allowed_ports = proxyConfig_.getAllowedPorts();
-                
-                bool isSiteBlocked = false;
-                bool isPortBlocked = false;
-                bool isSiteAllowed = false;
-                bool isPortAllowed = false;
-
-                if (allowed_sites[0] == "all")
-                {
-                    isSiteAllowed = true;
-                }
-                else
-                {
-                    isSiteBlocked = std::find(blocked_sites.begin(), blocked_sites.end(), address) != blocked_sites.end();
-                    isSiteAllowed = std::find(allowed_sites.begin(), allowed_sites.end(), address) != allowed_sites.end();
-                }
+boost::asio::awaitable<bool> ProxyServer::ProxySession::receive(std::size_t count) {
+    // Whatever the client sent ahead is parsed first; the socket is only read while the message is incomplete.
+    boost::system::error_code error;
+    while (handshake_.size() < count) {
+        const std::size_t bytes = co_await client_socket_.async_read_some(handshake_.prepare(), session_token(error));
+        if (error) {
+            co_return false;
+        }
+        handshake_.commit(bytes);
+    }
+    co_return true;
+}
 
-                if (allowed_ports[0] == -1)
-                {
-                    isPortAllowed = true;
-                }
-                else
-                {
-                    isPortBlocked = std::find(blocked_ports.begin(), blocked_ports.end(), port) != blocked_ports.end();
-                    isPortAllowed = std::find(allowed_ports.begin(), allowed_ports.end(), port) != allowed_ports.end();
-                }
+bool ProxyServer::ProxySession::handle_authentication(const Authentication_Result& result) {
+    if (!result.error.empty())
+    {
+        std::cerr << "Error while authenticating: " << result.error << std::endl;
+        log_to_file(spdlog::level::err, client_ip_, "Error while authenticating: " + result.error);
+        return false;
+    }
 
-                std::cout << "Resolved " << address << ":" << port << std::endl;
-                log_to_file(spdlog::level::info, client_socket_.remote_endpoint().address().to_string(), "Resolved: " + address + ":" + std::to_string(port) + ".");
+    if (!result.authenticated) {
+        std::cerr << "Authentication failed." << std::endl;
+        log_to_file(spdlog::level::err, client_ip_, "Authentication failed.");
+        return false;
+    }
 
-                if (isSiteBlocked || isPortBlocked) {
-                    // Send a socks reply indicating forbidden access
-                    send_socks_reply(7);
-                    return;
-                }
-                else if (isSiteAllowed && isPortAllowed) {
-                    try {
-                        boost::asio::ip::tcp::resolver resolver(server_socket_.get_executor());
-                        boost::asio::ip::tcp::resolver::query target_query(address, std::to_string(port));
-                        boost::asio::async_connect(server_socket_, resolver.resolve(target_query),
-                            [self = shared_from_this()](const boost::system::error_code& connect_error,
-                                const boost::asio::ip::tcp::endpoint& endpoint) {
-                                    self->handle_connect(connect_error);
-                            });
-                    }
-                    catch (const std::exception& e) {
-                        std::cerr << "Exception: " << e.what() << std::endl;
+    std::cout << "Authenticated successfuly with method: " << result.authentication_method << std::endl;
+    log_to_file(spdlog::level::info, client_ip_, "Authenticated successfuly with method: " + std::to_string(result.authentication_method));
+    return true;
+}
 
-                        log_to_file(spdlog::level::err, client_socket_.remote_endpoint().address().to_string(), "Exception: " + std::string(e.what()));
-                    }
-                }
-                else {
-                    // neither blocked or allowed
-                    send_socks_reply(5);
-                    return;
-                }
+int ProxyServer::ProxySession::handle_socks_request(std::size_t bytes_transferred, std::string& address, unsigned short& port, bool& is_domain) {
+    const char* request_data = reinterpret_cast<const char*>(handshake_.data());
+
+    std::cout << "Handling SOCKS5 request..." << std::endl;
+    int version = static_cast<unsigned char>(request_data[0]); // The socks version
+    int command = static_cast<unsigned char>(request_data[1]); // The socks command
+    int reserved = static_cast<unsigned char>(request_data[2]); // The reserved field
+    int address_type = static_cast<unsigned char>(request_data[3]); // The address type
+    std::cout << "bytes transferred: " << bytes_transferred << std::endl;
+    std::cout << "Received SOCKS version: " << version << std::endl;
+    std::cout << "Received SOCKS command: " << command << std::endl;
+    std::cout << "Received SOCKS reserved: " << reserved << std::endl;
+    std::cout << "Received SOCKS address type: " << address_type << std::endl;
+
+    std::string address_type_string = "";
+
+    // Check if the socks version is valid
+    if (version != SOCKS_VERSION) {
+        return 1;
+    }
+    // Check if the socks command is connect
+    if (command != 1) {
+        // Send a socks reply with command not supported
+        return 7;
+    }
+
+    switch (address_type) {
+    case 1: // IPv4 address
+        std::cout << "address type is IPv4" << std::endl;
+        address_type_string = "IPv4";
+        if (bytes_transferred >= 10) {
+            address = boost::asio::ip::address_v4(
+                boost::asio::detail::socket_ops::network_to_host_long(
+                    *reinterpret_cast<const unsigned long*>(request_data + 4)))
+                .to_string();
+            port = boost::asio::detail::socket_ops::network_to_host_short(
+                *reinterpret_cast<const unsigned short*>(request_data + 8));
+        }
+        else {
+            // Send a socks reply with address type not supported
+            boost::asio::ip::tcp::endpoint clientEndpoint = client_socket_.remote_endpoint();
+            std::cout << "Client connected from: " << clientEndpoint.address() << ":" << clientEndpoint.port() << std::endl;
+            return 8;
+        }
+        break;
+    case 3: // Domain name
+        std::cout << "address type is domain name" << std::endl;
+        address_type_string = "domain name";
+        if (bytes_transferred >= 5) { // Ensure enough data for domain name length
+            const std::size_t length = static_cast<unsigned char>(request_data[4]);
+            if (bytes_transferred >= 5 + length + 2) { // Ensure enough data for domain name and port
+                address = std::string(request_data + 5, length);
+                port = boost::asio::detail::socket_ops::network_to_host_short(
+                    *reinterpret_cast<const unsigned short*>(request_data + 5 + length));
+            }
+            else {
+                // Send a socks reply with address type not supported
+                return 8;
+            }
+        }
+        else {
+            // Send a socks reply with address type not supported
+            return 8;
+        }
+        break;
+    case 4: // IPv6 address
+        std::cout << "address type is IPv6" << std::endl;
+        address_type_string = "IPv6";
+        if (bytes_transferred >= 22) {
+            boost::asio::ip::address_v6::bytes_type ipv6_bytes;
+            for (int i = 0; i < 16; ++i) {
+                ipv6_bytes[i] = static_cast<unsigned char>(request_data[i + 4]);
             }
+            boost::asio::ip::address_v6 ipv6_address(ipv6_bytes);
+
+            port = boost::asio::detail::socket_ops::network_to_host_short(
+                *reinterpret_cast<const unsigned short*>(request_data + 20));
+
+            address = ipv6_address.to_string();
         }
         else {
-            send_socks_reply(1);
+            // Send a socks reply with address type not supported
+            return 8;
         }
+        break;
+    default: // Invalid address type
+        boost::asio::ip::tcp::endpoint clientEndpoint = client_socket_.remote_endpoint();
+        std::cout << "Client connected from: " << clientEndpoint.address() << ":" << clientEndpoint.port() << std::endl;
+        address_type_string = clientEndpoint.address().to_string() + ":" + std::to_string(clientEndpoint.port());
+        return 8;
     }
-    else {
-        close();
+
+    const std::string message = "Handling SOCKS5 request (bytes transferred: " + std::to_string(bytes_transferred) +
+        ", version: " + std::to_string(version) +
+        ", command: " + std::to_string(command) +
+        ", reserved: " + std::to_string(reserved) +
+        ", address type: " + address_type_string + ").";
+    log_to_file(spdlog::level::info, client_ip_, message);
+
+    // Host names are matched by name, address literals by the longest matching prefix.
+    boost::system::error_code address_error;
+    const Acl_Action site_action = address_type == 3
+        ? policy_->acl().check_host(address)
+        : policy_->acl().check_address(boost::asio::ip::make_address(address, address_error));
+    const bool isSiteBlocked = site_action == Acl_Action::Deny;
+    const bool isSiteAllowed = site_action == Acl_Action::Allow && !address_error;
+
+    const Acl_Action port_action = policy_->check_port(port);
+    const bool isPortBlocked = port_action == Acl_Action::Deny;
+    const bool isPortAllowed = port_action == Acl_Action::Allow;
+
+    std::cout << "Resolved " << address << ":" << port << std::endl;
+    log_to_file(spdlog::level::info, client_ip_, "Resolved: " + address + ":" + std::to_string(port) + ".");
+
+    if (isSiteBlocked || isPortBlocked) {
+        // Send a socks reply indicating forbidden access
+        return 7;
+    }
+    if (!isSiteAllowed || !isPortAllowed) {
+        // neither blocked or allowed
+        return 5;
     }
+    is_domain = address_type == 3;
+    return 0;
+}
 
+boost::asio::awaitable<std::shared_ptr<const DnsCache::Addresses>> ProxyServer::ProxySession::resolve(const std::string& hostname, boost::system::error_code& error) {
+    // Domain names go through the shared DNS cache; the reactor never waits for a lookup.
+    auto token = boost::asio::redirect_error(boost::asio::use_awaitable, error);
+    co_return co_await boost::asio::async_initiate<decltype(token), void(boost::system::error_code, std::shared_ptr<const DnsCache::Addresses>)>(
+        [this, &hostname](auto handler) {
+            // Resolve_Handler must be copyable, the coroutine's handler is move-only.
+            auto shared_handler = std::make_shared<decltype(handler)>(std::move(handler));
+            dns_cache_->async_resolve(hostname, server_socket_.get_executor(),
+                [shared_handler](const boost::system::error_code& resolve_error, const std::shared_ptr<const DnsCache::Addresses>& addresses) {
+                    (*shared_handler)(resolve_error, addresses);
+                });
+        },
+        token);
 }
 
-void ProxyServer::ProxySession::handle_connect(const boost::system::error_code& error) {
-    if (!error) {
-        send_socks_reply(0);
-        forward_data();
+boost::asio::awaitable<int> ProxyServer::ProxySession::connect_to_target(const std::string& address, unsigned short port, bool is_domain) {
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+    boost::system::error_code error;
+    if (is_domain) {
+        const std::shared_ptr<const DnsCache::Addresses> addresses = co_await resolve(address, error);
+        if (!client_socket_.is_open()) {
+            // The connect timeout closed the session while the name was resolved; there is nothing left to connect for.
+            co_return 5;
+        }
+        if (error) {
+            std::cerr << "Unable to resolve " << address << ": " << error.message() << std::endl;
+            log_to_file(spdlog::level::err, client_ip_, "Unable to resolve " + address + ": " + error.message());
+
+            // Send a socks reply with host unreachable
+            co_return 4;
+        }
+
+        // A name may be allowed while some of the addresses it resolves to fall into a blocked prefix.
+        endpoints.reserve(addresses->size());
+        for (const boost::asio::ip::address& target_address : *addresses) {
+            if (policy_->acl().check_address(target_address) != Acl_Action::Deny) {
+                endpoints.emplace_back(target_address, port);
+            }
+        }
+
+        if (endpoints.empty()) {
+            log_to_file(spdlog::level::info, client_ip_, "All addresses of " + address + " are blocked.");
+
+            // Send a socks reply with connection not allowed by ruleset
+            co_return 2;
+        }
     }
     else {
-        // Send a socks reply with connection refused
-        send_socks_reply(5);
+        endpoints.emplace_back(boost::asio::ip::make_address(address), port);
+    }
+
+    // The addresses are raced, so an unreachable one costs the attempt delay instead of a connect timeout.
+    connector_ = std::make_shared<HappyEyeballs>(server_socket_.get_executor(), endpoints, policy_->connect_attempt_delay());
+    auto token = boost::asio::redirect_error(boost::asio::use_awaitable, error);
+    server_socket_ = co_await boost::asio::async_initiate<decltype(token), void(boost::system::error_code, boost::asio::ip::tcp::socket)>(
+        [this](auto handler) {
+            // Connect_Handler must be copyable, the coroutine's handler is move-only.
+            auto shared_handler = std::make_shared<decltype(handler)>(std::move(handler));
+            connector_->async_connect(
+                [shared_handler](const boost::system::error_code& connect_error, boost::asio::ip::tcp::socket socket) {
+                    (*shared_handler)(connect_error, std::move(socket));
+                });
+        },
+        token);
+    connector_.reset();
+    if (!error && !client_socket_.is_open()) {
+        // The session closed as the connection was made, after the race could no longer be cancelled.
+        server_socket_.close(error);
+        error = boost::asio::error::operation_aborted;
+    }
+    if (!error) {
+        enable_keep_alive(server_socket_, *policy_);
     }
+
+    // Send a socks reply with connection refused on failure
+    co_return error ? 5 : 0;
 }
 
-void ProxyServer::ProxySession::send_socks_reply(int status) {
+boost::asio::awaitable<int> ProxyServer::ProxySession::connect_buffering(const std::string& address, unsigned short port, bool is_domain) {
+    // The connect runs in a coroutine of its own. Once done it cancels the pending read, or the timer
+    // this coroutine waits on when the buffer is full.
+    int connect_status = -1;
+    boost::asio::steady_timer connected(client_socket_.get_executor(), boost::asio::steady_timer::time_point::max());
+    boost::asio::co_spawn(client_socket_.get_executor(),
+        [self = shared_from_this(), &connect_status, &connected, address, port, is_domain]() -> boost::asio::awaitable<void> {
+            connect_status = co_await self->connect_to_target(address, port, is_domain);
+            connected.cancel();
+            boost::system::error_code ignored;
+            self->client_socket_.cancel(ignored);
+        },
+        boost::asio::detached);
+
+    // Past the cap the client is held back by TCP flow control until the relay starts.
+    const std::size_t cap = policy_->optimistic_buffer_size();
+    handshake_.reserve(cap);
+    boost::system::error_code error;
+    bool client_failed = false;
+    while (connect_status < 0 && handshake_.size() < cap) {
+        // The free space of the buffer may exceed the room left under the cap.
+        const std::size_t bytes = co_await client_socket_.async_read_some(boost::asio::buffer(handshake_.prepare(), cap - handshake_.size()), session_token(error));
+        handshake_.commit(bytes);
+        if (error == boost::asio::error::operation_aborted) {
+            continue;
+        }
+        if (error) {
+            // End of stream is left for the relay to pass on; anything else aborts the connect.
+            if (error != boost::asio::error::eof) {
+                client_failed = true;
+                if (connector_) {
+                    connector_->cancel();
+                }
+            }
+            break;
+        }
+    }
+
+    while (connect_status < 0) {
+        co_await connected.async_wait(session_token(error));
+    }
+
+    // General failure if the client went away in the meantime
+    co_return client_failed ? 1 : connect_status;
+}
+
+boost::asio::awaitable<int> ProxyServer::ProxySession::forward_early_data() {
+    // Payload the client sent ahead of the relay reaches the target before anything else.
+    log_to_file(spdlog::level::info, client_ip_, "Forwarding " + std::to_string(handshake_.size()) + " bytes received before the target was connected.");
+
+    boost::system::error_code error;
+    co_await boost::asio::async_write(
+        server_socket_,
+        boost::asio::buffer(handshake_.data(), handshake_.size()),
+        session_token(error));
+    handshake_.consume(handshake_.size());
+
+    // Send a socks reply with general failure if the target did not take it
+    co_return error ? 1 : 0;
+}
+
+boost::asio::awaitable<void> ProxyServer::ProxySession::send_socks_reply(int status) {
     std::cout << "Sending SOCKS reply with status: " << status << std::endl;
     const std::string message = "Sending SOCKS reply with status: " + std::to_string(status);
-    log_to_file(spdlog::level::info, client_socket_.remote_endpoint().address().to_string(), message);
+    log_to_file(spdlog::level::info, client_ip_, message);
 
-    server_data_[0] = SOCKS_VERSION;
-    server_data_[1] = status;
-    server_data_[2] = 0;
-    server_data_[3] = 1;
+    reply_data_[0] = SOCKS_VERSION;
+    reply_data_[1] = status;
+    reply_data_[2] = 0;
+    reply_data_[3] = 1;
 
-    boost::asio::async_write(
+    boost::system::error_code error;
+    co_await boost::asio::async_write(
         client_socket_,
-        boost::asio::buffer(server_data_, 10),
-        boost::bind(&ProxySession::handle_write, this,
-            boost::asio::placeholders::error));
+        boost::asio::buffer(reply_data_, SOCKS_REPLY_SIZE),
+        session_token(error));
+    if (error) {
+        close();
+    }
 }
-void ProxyServer::ProxySession::handle_write(const boost::system::error_code& error) {
-    if (!error) {
-        // Do nothing
+
+void ProxyServer::ProxySession::forward_data(unsigned short port) {
+    const std::string client_ip = client_ip_;
+    arm_timeout(policy_->idle_timeout(), "idle");
+
+    shaping_ = shaper_->attach(username_, client_ip_, *policy_);
+    relay_quantum_ = policy_->relay_quantum(port, username_);
+
+    if (policy_->relay_engine() == 1) {
+        if (start_splice_relay()) {
+            log_to_file(spdlog::level::info, client_ip, "Relay engine: splice.");
+            return;
+        }
+        log_to_file(spdlog::level::info, client_ip, "Relay engine: copy (splice unavailable).");
+    }
+    else if (policy_->relay_engine() == 2 && shaping_.limited()) {
+        // The kernel receives into the buffer ring on its own, so a tunnel relayed by io_uring cannot be held back.
+        log_to_file(spdlog::level::info, client_ip, "Relay engine: copy (rate limited).");
+    }
+    else if (policy_->relay_engine() == 2) {
+        if (start_uring_relay()) {
+            log_to_file(spdlog::level::info, client_ip, "Relay engine: io_uring.");
+            return;
+        }
+        log_to_file(spdlog::level::info, client_ip, "Relay engine: copy (io_uring unavailable).");
     }
     else {
+        log_to_file(spdlog::level::info, client_ip, "Relay engine: copy.");
+    }
+
+    // Reads are attempted only after the socket reported readiness and must not block when it has nothing after all.
+    boost::system::error_code error;
+    client_socket_.non_blocking(true, error);
+    if (!error) {
+        server_socket_.non_blocking(true, error);
+    }
+    if (error) {
         close();
+        return;
     }
+
+    for (Copy_Relay* relay : { &client_relay_, &server_relay_ }) {
+        relay->depth = policy_->relay_depth();
+        relay->chunks = std::make_unique<Copy_Relay::Chunk[]>(relay->depth);
+        relay->buffer_size = policy_->relay_min_buffer_size();
+    }
+    spawn_relays();
 }
 
-void ProxyServer::ProxySession::forward_data() {
-    client_socket_.async_read_some(
-        boost::asio::buffer(client_data_, BUFFER_SIZE),
-        [self = shared_from_this()](boost::system::error_code error, std::size_t bytes_transferred) {
-            self->handle_client_read(error, bytes_transferred);
-        });
+void ProxyServer::ProxySession::spawn_relays() {
+    client_state_ = Relay_State::Running;
+    server_state_ = Relay_State::Running;
+    if (client_pipe_) {
+        boost::asio::co_spawn(client_socket_.get_executor(),
+            [self = shared_from_this()] {
+                return self->splice_relay(self->client_state_, *self->client_pipe_, self->client_socket_, self->server_socket_);
+            },
+            boost::asio::detached);
+        boost::asio::co_spawn(client_socket_.get_executor(),
+            [self = shared_from_this()] {
+                return self->splice_relay(self->server_state_, *self->server_pipe_, self->server_socket_, self->client_socket_);
+            },
+            boost::asio::detached);
+        return;
+    }
 
-    server_socket_.async_read_some(
-        boost::asio::buffer(server_data_, BUFFER_SIZE),
-        [self = shared_from_this()](boost::system::error_code error, std::size_t bytes_transferred) {
-            self->handle_server_read(error, bytes_transferred);
-        });
+    boost::asio::co_spawn(client_socket_.get_executor(),
+        [self = shared_from_this()] {
+            return self->copy_relay(self->client_state_, self->client_relay_, self->client_socket_, self->server_socket_);
+        },
+        boost::asio::detached);
+    boost::asio::co_spawn(client_socket_.get_executor(),
+        [self = shared_from_this()] {
+            return self->copy_relay(self->server_state_, self->server_relay_, self->server_socket_, self->client_socket_);
+        },
+        boost::asio::detached);
 }
 
-void ProxyServer::ProxySession::handle_client_read(const boost::system::error_code& error, std::size_t bytes_transferred) {
+bool ProxyServer::ProxySession::start_splice_relay() {
+    client_pipe_ = std::make_unique<SplicePipe>();
+    server_pipe_ = std::make_unique<SplicePipe>();
+    if (!client_pipe_->open() || !server_pipe_->open()) {
+        client_pipe_.reset();
+        server_pipe_.reset();
+        return false;
+    }
+
+    // splice(2) only honours non-blocking mode on the socket side when the descriptor itself is non-blocking.
+    boost::system::error_code error;
+    client_socket_.native_non_blocking(true, error);
     if (!error) {
-        boost::asio::async_write(
-            server_socket_,
-            boost::asio::buffer(client_data_, bytes_transferred),
-            [self = shared_from_this()](const boost::system::error_code& write_error, std::size_t) {
-                if (!write_error) {
-                    self->client_socket_.async_read_some(
-                        boost::asio::buffer(self->client_data_, BUFFER_SIZE),
-                        [self](const boost::system::error_code& read_error, std::size_t read_bytes) {
-                            self->handle_client_read(read_error, read_bytes);
-                        });
-                }
-                else {
-                    self->close();
-                }
-            });
+        server_socket_.native_non_blocking(true, error);
     }
-    else {
-        close();
+    if (error) {
+        client_pipe_.reset();
+        server_pipe_.reset();
+        return false;
     }
+    spawn_relays();
+    return true;
 }
 
-void ProxyServer::ProxySession::handle_server_read(const boost::system::error_code& error, std::size_t bytes_transferred) {
-    if (!error) {
-        boost::asio::async_write(
-            client_socket_,
-            boost::asio::buffer(server_data_, bytes_transferred),
-            [self = shared_from_this()](const boost::system::error_code& write_error, std::size_t) {
-                if (!write_error) {
-
-                    self->server_socket_.async_read_some(
-                        boost::asio::buffer(self->server_data_, BUFFER_SIZE),
-                        [self](const boost::system::error_code& read_error, std::size_t read_bytes) {
-                            self->handle_server_read(read_error, read_bytes);
-                        });
-                }
-                else {
-                    self->close();
-                }
-            });
+bool ProxyServer::ProxySession::start_uring_relay() {
+    if (!shard_->uring_relay) {
+        return false;
     }
-    else {
-        close();
+
+    // The relay keeps the session alive until the tunnel has ended and then lets it close its sockets. Like the copy
+    // relay, a direction holds at most relay_depth chunks its destination has not taken yet.
+    uring_tunnel_ = shard_->uring_relay->relay(client_socket_.native_handle(), server_socket_.native_handle(), policy_->relay_depth(),
+        [self = shared_from_this()] {
+            self->uring_tunnel_ = 0;
+            self->close();
+        });
+    return uring_tunnel_ != 0;
+}
+
+boost::asio::awaitable<void> ProxyServer::ProxySession::splice_relay(Relay_State& state, SplicePipe& pipe, boost::asio::ip::tcp::socket& source, boost::asio::ip::tcp::socket& destination) {
+    boost::asio::steady_timer pause(source.get_executor());
+    boost::system::error_code error;
+    while (true) {
+        // The pipe is empty between rounds, so the tunnel may move to another shard here.
+        if (migration_ != nullptr && park(state)) {
+            co_return;
+        }
+        const std::size_t budget = co_await wait_for_budget(pause, source);
+        state = Relay_State::Reading;
+        co_await source.async_wait(boost::asio::ip::tcp::socket::wait_read, session_token(error));
+        state = Relay_State::Running;
+        // Only a move cancels the wait of an open socket; it stops the direction at the top of the loop, or resumes the wait if it was dropped.
+        if (error == boost::asio::error::operation_aborted && source.is_open()) {
+            continue;
+        }
+        if (error || budget == 0) {
+            break;
+        }
+
+        const std::size_t bytes = pipe.fill(source, (std::min)(budget, relay_quantum_), error);
+        if (error == boost::asio::error::would_block) {
+            continue;
+        }
+        if (error) {
+            break;
+        }
+        touch();
+        relayed_bytes_ += bytes;
+        if (shaping_.limited()) {
+            shaping_.consume(bytes, std::chrono::steady_clock::now());
+        }
+
+        // Moves the data buffered in the pipe to the destination, waiting for it to become writable as needed.
+        pipe.drain(destination, error);
+        while (pipe.pending() > 0 && (!error || error == boost::asio::error::would_block)) {
+            co_await destination.async_wait(boost::asio::ip::tcp::socket::wait_write, session_token(error));
+            if (error) {
+                break;
+            }
+            pipe.drain(destination, error);
+        }
+        if (error && error != boost::asio::error::would_block) {
+            break;
+        }
     }
+    close();
 }
-void ProxyServer::ProxySession::handle_server_write(const boost::system::error_code& error) {
-    if (!error) {
-        // Do nothing
+
+boost::asio::awaitable<void> ProxyServer::ProxySession::copy_relay(Relay_State& state, Copy_Relay& relay, boost::asio::ip::tcp::socket& source, boost::asio::ip::tcp::socket& destination) {
+    boost::asio::steady_timer pause(source.get_executor());
+    // Never expires on its own; the writer cancels its wait whenever it returned chunks to the pool or ended.
+    boost::asio::steady_timer wake(source.get_executor(), boost::asio::steady_timer::time_point::max());
+    boost::system::error_code error;
+    bool finished = false;
+    while (!finished) {
+        // A rate limited direction waits for its budget before reading, so the data over it stays in the kernel.
+        // Every round starts with a wait for readiness, whose completion is queued behind the handlers already
+        // ready on the reactor, so a direction that used up its quantum yields to the other sessions of its
+        // shard: the reactor's queue serves the directions round robin, each relaying at most its quantum per turn.
+        // No buffer is checked out once the writer has ended, so the tunnel may move to another shard here.
+        if (migration_ != nullptr && !relay.writing && park(state)) {
+            co_return;
+        }
+        // With every chunk filled, reading resumes once the writer returned the oldest ones to the pool.
+        if (relay.filled == relay.depth) {
+            co_await wake.async_wait(session_token(error));
+            if (relay.failed) {
+                break;
+            }
+            continue;
+        }
+        std::size_t budget = co_await wait_for_budget(pause, source);
+        // A move may only cancel the wait while nothing is being written to the other direction's source.
+        state = relay.writing ? Relay_State::Running : Relay_State::Reading;
+        relay.awaiting_data = true;
+        co_await source.async_wait(boost::asio::ip::tcp::socket::wait_read, session_token(error));
+        relay.awaiting_data = false;
+        state = Relay_State::Running;
+        // Only a move cancels the wait of an open socket; it stops the direction at the top of the loop, or resumes the wait if it was dropped.
+        if (error == boost::asio::error::operation_aborted && source.is_open()) {
+            continue;
+        }
+        if (error || budget == 0 || relay.failed) {
+            break;
+        }
+        budget = (std::min)(budget, relay_quantum_);
+
+        // Fill as many free chunks as the socket has data for, so a busy tunnel does not wait for readiness per chunk.
+        std::size_t total = 0;
+        while (relay.filled < relay.depth && budget > 0) {
+            Copy_Relay::Chunk& chunk = relay.chunks[(relay.head + relay.filled) % relay.depth];
+            chunk.buffer = BufferPool::acquire(relay.buffer_size);
+            const std::size_t capacity = (std::min)(chunk.buffer.size(), budget);
+            const std::size_t bytes = source.read_some(boost::asio::buffer(chunk.buffer.data(), capacity), error);
+            if (error == boost::asio::error::would_block) {
+                chunk.buffer.reset();
+                break;
+            }
+            if (error) {
+                chunk.buffer.reset();
+                // Data already read is still delivered before the session closes.
+                finished = true;
+                break;
+            }
+
+            chunk.size = bytes;
+            ++relay.filled;
+            total += bytes;
+            budget -= bytes;
+            adapt_buffer_size(relay, bytes, capacity);
+        }
+        if (total == 0) {
+            continue;
+        }
+        touch();
+        relayed_bytes_ += total;
+        if (shaping_.limited()) {
+            shaping_.consume(total, std::chrono::steady_clock::now());
+        }
+
+        // A running writer picks the new chunks up with its next write.
+        if (!relay.writing) {
+            relay.writing = true;
+            boost::asio::co_spawn(source.get_executor(),
+                [self = shared_from_this(), &state, &relay, &wake, &destination] {
+                    return self->copy_write(state, relay, wake, destination);
+                },
+                boost::asio::detached);
+        }
     }
-    else {
-        close();
+
+    // The writer refers to the wake timer, so the direction ends only after it has written the chunks left.
+    while (relay.writing) {
+        co_await wake.async_wait(session_token(error));
     }
+    close();
 }
-void ProxyServer::ProxySession::handle_client_write(const boost::system::error_code& error) {
-    if (!error) {
-        // Do nothing
+
+boost::asio::awaitable<void> ProxyServer::ProxySession::copy_write(Relay_State& state, Copy_Relay& relay, boost::asio::steady_timer& wake, boost::asio::ip::tcp::socket& destination) {
+    std::array<boost::asio::const_buffer, Policy::MAX_RELAY_DEPTH> buffers;
+    boost::system::error_code error;
+    while (relay.filled > 0) {
+        // Chunks filled while this write is in flight go out with the next one.
+        const std::size_t count = relay.filled;
+        for (std::size_t i = 0; i < count; ++i) {
+            const Copy_Relay::Chunk& chunk = relay.chunks[(relay.head + i) % relay.depth];
+            buffers[i] = boost::asio::buffer(chunk.buffer.data(), chunk.size);
+        }
+        co_await boost::asio::async_write(destination, std::span<const boost::asio::const_buffer>(buffers.data(), count),
+            session_token(error));
+        for (std::size_t i = 0; i < count; ++i) {
+            relay.chunks[(relay.head + i) % relay.depth].buffer.reset();
+        }
+        relay.head = (relay.head + count) % relay.depth;
+        relay.filled -= count;
+        if (error) {
+            // The chunks filled meanwhile can no longer be delivered.
+            for (; relay.filled > 0; --relay.filled) {
+                relay.chunks[relay.head].buffer.reset();
+                relay.head = (relay.head + 1) % relay.depth;
+            }
+            relay.failed = true;
+            close();
+            break;
+        }
+        wake.cancel();
     }
-    else {
-        close();
+
+    relay.writing = false;
+    if (relay.awaiting_data) {
+        state = Relay_State::Reading;
+    }
+    wake.cancel();
+}
+
+void ProxyServer::ProxySession::adapt_buffer_size(Copy_Relay& relay, std::size_t bytes, std::size_t capacity) {
+    if (bytes == capacity) {
+        relay.small_reads = 0;
+        relay.buffer_size = (std::min)(relay.buffer_size * BUFFER_GROWTH_FACTOR, policy_->relay_max_buffer_size());
+    }
+    else if (bytes >= capacity / 4) {
+        relay.small_reads = 0;
+    }
+    else if (++relay.small_reads >= SHRINK_AFTER_SMALL_READS) {
+        relay.small_reads = 0;
+        relay.buffer_size = (std::max)(relay.buffer_size / 2, policy_->relay_min_buffer_size());
+    }
+}
+
+boost::asio::awaitable<std::size_t> ProxyServer::ProxySession::wait_for_budget(boost::asio::steady_timer& pause, boost::asio::ip::tcp::socket& source) {
+    if (!shaping_.limited()) {
+        co_return std::numeric_limits<std::size_t>::max();
+    }
+
+    boost::system::error_code error;
+    while (source.is_open()) {
+        std::chrono::nanoseconds wait;
+        const std::size_t budget = shaping_.budget(std::chrono::steady_clock::now(), wait);
+        if (budget > 0) {
+            co_return budget;
+        }
+        pause.expires_after((std::min)(std::chrono::duration_cast<std::chrono::steady_clock::duration>(wait), std::chrono::steady_clock::duration(MAX_SHAPING_PAUSE)));
+        co_await pause.async_wait(session_token(error));
     }
+    co_return 0;
 }
 
 void ProxyServer::ProxySession::log_to_file(const spdlog::level::level_enum log_level, const std::string& IP, const std::string& message)
@@ -407,22 +1114,410 @@ void ProxyServer::ProxySession::log_to_file(const spdlog::level::level_enum log_
     }
 }
 
+void ProxyServer::ProxySession::arm_timeout(std::chrono::seconds timeout, const char* phase) {
+    timeout_phase_ = phase;
+    if (timeout.count() == 0) {
+        disarm();
+        return;
+    }
+    shard_->timeouts.arm(*this, timeout);
+}
+
+void ProxyServer::ProxySession::handle_timeout() {
+    // io_uring relays the tunnel without the session seeing the data, so its activity is polled instead.
+    if (uring_tunnel_ != 0) {
+        const std::uint64_t activity = shard_->uring_relay->activity(uring_tunnel_);
+        if (activity != uring_activity_) {
+            uring_activity_ = activity;
+            shard_->timeouts.arm(*this, policy_->idle_timeout());
+            return;
+        }
+    }
+
+    // Closing an io_uring tunnel may release the last reference to the session. Closing also cancels a
+    // connection race still in flight, and a lookup that completes later finds the client socket closed.
+    const std::shared_ptr<ProxySession> self = shared_from_this();
+    log_to_file(spdlog::level::info, client_ip_, std::string("Closing the session after the ") + timeout_phase_ + " timeout.");
+    close();
+}
+
 void ProxyServer::ProxySession::close() {
+    disarm();
+    migration_ = nullptr;
+    if (connector_) {
+        connector_->cancel();
+    }
+    if (uring_tunnel_ != 0) {
+        shard_->uring_relay->abort(uring_tunnel_);
+        uring_tunnel_ = 0;
+    }
     client_socket_.close();
     server_socket_.close();
+    admission_.release();
+    unlink();
 }
 
-// Proxy server function definitions
+std::uint64_t ProxyServer::ProxySession::sample_rate(std::chrono::steady_clock::duration elapsed) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    relay_rate_ = seconds > 0.0 ? static_cast<std::uint64_t>((relayed_bytes_ - sampled_bytes_) / seconds) : 0;
+    sampled_bytes_ = relayed_bytes_;
+    return relay_rate_;
+}
 
-void ProxyServer::start_accept(std::shared_ptr<boost::asio::ip::tcp::socket> socket) {
-    acceptor_.async_accept(
-        *socket,
-        [this, socket](const boost::system::error_code& error) {
+bool ProxyServer::ProxySession::migratable(std::chrono::steady_clock::time_point now) const {
+    return client_state_ != Relay_State::Idle && migration_ == nullptr && client_socket_.is_open()
+        && !shaping_.limited() && now - migrated_at_ >= MIGRATION_COOLDOWN;
+}
+
+std::uint64_t ProxyServer::ProxySession::relay_rate() const {
+    return relay_rate_;
+}
+
+void ProxyServer::ProxySession::migrate(Shard& target) {
+    migration_ = &target;
+    // Directions waiting for data are woken right away; one that is writing stops once its round is done.
+    if (client_state_ == Relay_State::Reading && server_state_ == Relay_State::Reading) {
+        boost::system::error_code ignored;
+        client_socket_.cancel(ignored);
+        server_socket_.cancel(ignored);
+    }
+}
+
+void ProxyServer::ProxySession::abandon_migration() {
+    // Once a direction has stopped, the other one is about to stop as well and hand the tunnel over.
+    if (client_state_ != Relay_State::Parked && server_state_ != Relay_State::Parked) {
+        migration_ = nullptr;
+    }
+}
+
+bool ProxyServer::ProxySession::park(Relay_State& state) {
+    Relay_State& other = &state == &client_state_ ? server_state_ : client_state_;
+    boost::asio::ip::tcp::socket& other_source = &state == &client_state_ ? server_socket_ : client_socket_;
+
+    // A running direction may be writing to the source of this one, so this one may only stop once the other waits for data.
+    if (other == Relay_State::Running) {
+        return false;
+    }
+    state = Relay_State::Parked;
+    if (other == Relay_State::Parked) {
+        hand_over();
+    }
+    else {
+        // Nothing writes to the other direction's source any more, so cancelling its wait affects no other operation.
+        boost::system::error_code ignored;
+        other_source.cancel(ignored);
+    }
+    return true;
+}
+
+void ProxyServer::ProxySession::hand_over() {
+    Shard& target = *std::exchange(migration_, nullptr);
+    migrated_at_ = std::chrono::steady_clock::now();
+
+    // A shard that began draining no longer takes tunnels over.
+    if (!target.draining.load(std::memory_order_relaxed)) {
+        boost::system::error_code error;
+        const boost::asio::ip::tcp client_protocol = client_socket_.local_endpoint(error).protocol();
+        if (!error) {
+            const boost::asio::ip::tcp server_protocol = server_socket_.local_endpoint(error).protocol();
             if (!error) {
-                auto session = std::make_shared<ProxySession>(std::move(*socket), proxyConfig_, logging_method_, logger_, database_);
-                active_sessions_.emplace_back(session);
-                session->start();
+                const auto client = client_socket_.release(error);
+                if (!error) {
+                    const auto server = server_socket_.release(error);
+                    if (error) {
+                        client_socket_.assign(client_protocol, client, error);
+                    }
+                    else {
+                        // The session belongs to no shard until the target adopts it.
+                        disarm();
+                        unlink();
+                        client_socket_ = boost::asio::ip::tcp::socket(target.io_context);
+                        server_socket_ = boost::asio::ip::tcp::socket(target.io_context);
+                        boost::asio::post(target.io_context, [self = shared_from_this(), &target, client = std::make_pair(client_protocol, client), server = std::make_pair(server_protocol, server)] {
+                            self->take_over(target, client, server);
+                        });
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    // The target is draining, the platform cannot move sockets between io_contexts, or the tunnel is closing: it
+    // carries on where it is, unless a socket is closed already. A descriptor assigned back starts out in blocking mode, which the copy relay's direct reads must not see.
+    boost::system::error_code client_error;
+    boost::system::error_code server_error;
+    client_socket_.non_blocking(true, client_error);
+    server_socket_.non_blocking(true, server_error);
+    if (client_error || server_error) {
+        close();
+        return;
+    }
+    spawn_relays();
+}
+
+void ProxyServer::ProxySession::take_over(Shard& target, std::pair<boost::asio::ip::tcp, boost::asio::ip::tcp::socket::native_handle_type> client, std::pair<boost::asio::ip::tcp, boost::asio::ip::tcp::socket::native_handle_type> server) {
+    shard_ = &target;
+    target.sessions.add(*this);
+
+    // The descriptors are still non-blocking; the sockets only have to be told, for the copy relay's direct reads.
+    boost::system::error_code client_error;
+    boost::system::error_code server_error;
+    client_socket_.assign(client.first, client.second, client_error);
+    server_socket_.assign(server.first, server.second, server_error);
+    if (!client_error) {
+        client_socket_.non_blocking(true, client_error);
+    }
+    if (!server_error) {
+        server_socket_.non_blocking(true, server_error);
+    }
+    // A shard that began draining after the move was decided may have finished counting its tunnels already,
+    // so the tunnel is refused like on a stopped shard.
+    if (client_error || server_error || target.stopped || target.draining.load(std::memory_order_relaxed)) {
+        close();
+        return;
+    }
+
+    Metrics::instance().add(Metrics::Counter::Sessions_Migrated);
+    arm_timeout(policy_->idle_timeout(), "idle");
+    spawn_relays();
+}
+
+// Proxy server function definitions
+
+void ProxyServer::start_accept(Shard& shard, boost::asio::ip::tcp::acceptor& acceptor) {
+    // A shard with its own acceptor keeps every connection it accepts. Otherwise the single
+    // acceptor spreads connections over the shards, creating each socket on its target io_context.
+    Shard& target = acceptor_count_ == shards_.size() ? shard : *shards_[next_shard_++ % shards_.size()];
+
+    acceptor.async_accept(
+        target.io_context,
+        [this, &shard, &acceptor, &target](const boost::system::error_code& error, boost::asio::ip::tcp::socket socket) {
+            if (error == boost::asio::error::operation_aborted || !acceptor.is_open()) {
+                return;
             }
-            start_accept(socket);
+            if (error == boost::asio::error::no_descriptors || error == boost::system::errc::too_many_files_open_in_system
+                || error == boost::asio::error::no_buffer_space || error == boost::asio::error::no_memory) {
+                pause_accept(shard, acceptor);
+                return;
+            }
+            AdmissionControl::Ticket ticket;
+            if (!error && admit(shard, socket, ticket)) {
+                if (&target == &shard) {
+                    start_session(target, std::move(socket), std::move(ticket));
+                }
+                else {
+                    boost::asio::post(target.io_context, [this, &target, socket = std::move(socket), ticket = std::move(ticket)]() mutable {
+                        start_session(target, std::move(socket), std::move(ticket));
+                    });
+                }
+            }
+            start_accept(shard, acceptor);
         });
+}
+
+void ProxyServer::pause_accept(Shard& shard, boost::asio::ip::tcp::acceptor& acceptor) {
+    Metrics::instance().add(Metrics::Counter::Accept_Pauses);
+
+    // The paused accepts share one timer, which restarts all of them.
+    shard.paused_accepts.push_back(&acceptor);
+    if (shard.paused_accepts.size() > 1) {
+        return;
+    }
+    shard.accept_timer.expires_after(ACCEPT_PAUSE);
+    shard.accept_timer.async_wait([this, &shard](const boost::system::error_code& error) {
+        const std::vector<boost::asio::ip::tcp::acceptor*> paused = std::exchange(shard.paused_accepts, {});
+        if (error) {
+            return;
+        }
+        for (boost::asio::ip::tcp::acceptor* acceptor : paused) {
+            if (acceptor->is_open()) {
+                start_accept(shard, *acceptor);
+            }
+        }
+    });
+}
+
+void ProxyServer::retire_listener(Shard& shard, boost::asio::ip::tcp::acceptor listener) {
+    // The previous process no longer accepts, so once the backlog is empty no connection waits in the socket.
+    boost::system::error_code error;
+    listener.non_blocking(true, error);
+    while (!error) {
+        boost::asio::ip::tcp::socket socket(shard.io_context);
+        listener.accept(socket, error);
+        if (error == boost::asio::error::connection_aborted) {
+            error.clear();
+            continue;
+        }
+        AdmissionControl::Ticket ticket;
+        if (!error && admit(shard, socket, ticket)) {
+            start_session(shard, std::move(socket), std::move(ticket));
+        }
+    }
+    listener.close(error);
+}
+
+void ProxyServer::stop_accepting(Shard& shard) {
+    boost::system::error_code error;
+    if (shard.acceptor.is_open()) {
+        shard.acceptor.close(error);
+    }
+    for (auto& surplus : shard.surplus_acceptors) {
+        surplus->close(error);
+    }
+    shard.accept_timer.cancel();
+    shard.rebalance_timer.cancel();
+    shard.draining.store(true, std::memory_order_relaxed);
+}
+
+void ProxyServer::await_drain(Shard& shard, std::shared_ptr<Drain> drain) {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (shard.sessions.size() != 0 && !shard.stopped && now < drain->deadline) {
+        auto timer = std::make_shared<boost::asio::steady_timer>(shard.io_context, (std::min)(now + DRAIN_POLL_INTERVAL, drain->deadline));
+        timer->async_wait([this, &shard, drain, timer](const boost::system::error_code&) {
+            await_drain(shard, drain);
+        });
+        return;
+    }
+
+    // Tunnels still open at the deadline are closed.
+    shard.sessions.for_each([](ProxySession& session) {
+        session.close();
+    });
+    if (drain->pending_shards.fetch_sub(1) == 1 && drain->drained) {
+        drain->drained();
+    }
+}
+
+bool ProxyServer::admit(Shard& shard, boost::asio::ip::tcp::socket& socket, AdmissionControl::Ticket& ticket) {
+    const std::shared_ptr<const Policy> policy = policy_.load();
+
+    // Every acceptor takes its share of the rate; a reloaded rate applies from the next connection.
+    const double rate = policy->accept_rate() / static_cast<double>(acceptor_count_);
+    const double burst = (std::max)(policy->accept_burst() / static_cast<double>(acceptor_count_), 1.0);
+    if (shard.accept_rate.rate() != rate || shard.accept_rate.burst() != burst) {
+        shard.accept_rate.configure(rate, burst);
+    }
+    if (!shard.accept_rate.try_consume()) {
+        Metrics::instance().add(Metrics::Counter::Connections_Rate_Limited);
+        reject(socket, *policy);
+        return false;
+    }
+
+    boost::system::error_code error;
+    const boost::asio::ip::tcp::endpoint client_endpoint = socket.remote_endpoint(error);
+    if (error) {
+        // The client is gone already.
+        socket.close(error);
+        return false;
+    }
+
+    switch (admission_.admit(client_endpoint.address(), policy->max_sessions(), policy->max_sessions_per_source(), ticket)) {
+    case AdmissionControl::Verdict::Admitted:
+        return true;
+    case AdmissionControl::Verdict::Session_Limit:
+        Metrics::instance().add(Metrics::Counter::Connections_Over_Session_Limit);
+        break;
+    case AdmissionControl::Verdict::Source_Limit:
+        Metrics::instance().add(Metrics::Counter::Connections_Over_Source_Limit);
+        break;
+    }
+    reject(socket, *policy);
+    return false;
+}
+
+void ProxyServer::reject(boost::asio::ip::tcp::socket& socket, const Policy& policy) {
+    boost::system::error_code ignored;
+    if (policy.reject_with_reset()) {
+        // Closing with a zero linger time resets the connection, which frees it at once instead of leaving it in TIME_WAIT.
+        socket.set_option(boost::asio::socket_base::linger(true, 0), ignored);
+    }
+    else {
+        // The reply answers the greeting whether or not it has arrived yet. It fits the empty send buffer, so one
+        // non-blocking send is enough.
+        static const unsigned char reply[] = { static_cast<unsigned char>(SOCKS_VERSION), NO_ACCEPTABLE_METHODS };
+        socket.non_blocking(true, ignored);
+        socket.send(boost::asio::buffer(reply), 0, ignored);
+    }
+    socket.close(ignored);
+}
+
+void ProxyServer::start_session(Shard& shard, boost::asio::ip::tcp::socket socket, AdmissionControl::Ticket admission) {
+    auto session = std::make_shared<ProxySession>(std::move(socket), policy_.load(), logging_method_, logger_, database_, dns_cache_, shaper_, shard, std::move(admission));
+    shard.sessions.add(*session);
+    session->start();
+}
+
+void ProxyServer::schedule_rebalance(Shard& shard) {
+    const std::chrono::milliseconds interval = policy_.load()->rebalance_interval();
+    shard.rebalance_timer.expires_after(interval.count() > 0 ? interval : IDLE_REBALANCE_INTERVAL);
+    shard.rebalance_timer.async_wait([this, &shard](const boost::system::error_code& error) {
+        if (error || shard.draining.load(std::memory_order_relaxed)) {
+            return;
+        }
+        rebalance(shard);
+        schedule_rebalance(shard);
+    });
+}
+
+void ProxyServer::rebalance(Shard& shard) {
+    // The handler runs on the shard's reactor thread, so the thread's CPU time is the time it spent running handlers.
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::chrono::nanoseconds cpu_time = thread_cpu_time();
+    const std::chrono::steady_clock::duration elapsed = now - shard.sampled_at;
+    const double busy = elapsed.count() > 0 ? std::chrono::duration<double>(cpu_time - shard.cpu_time) / elapsed : 0.0;
+    shard.sampled_at = now;
+    shard.cpu_time = cpu_time;
+
+    // Moves that found no safe point since the last sample are dropped; the load they were meant to fix is stale.
+    std::uint64_t byte_rate = 0;
+    shard.sessions.for_each([elapsed, &byte_rate](ProxySession& session) {
+        session.abandon_migration();
+        byte_rate += session.sample_rate(elapsed);
+    });
+    shard.busy.store((std::min)(busy, 1.0), std::memory_order_relaxed);
+    shard.byte_rate.store(byte_rate, std::memory_order_relaxed);
+
+    const std::shared_ptr<const Policy> policy = policy_.load();
+    if (policy->rebalance_interval().count() == 0) {
+        return;
+    }
+
+    // Work stealing: the idle shard asks the busiest one for a tunnel, which that shard picks on its own thread.
+    Shard* busiest = nullptr;
+    for (auto& other : shards_) {
+        if (other.get() != &shard && (busiest == nullptr || other->busy.load(std::memory_order_relaxed) > busiest->busy.load(std::memory_order_relaxed))) {
+            busiest = other.get();
+        }
+    }
+    const double gap = busiest->busy.load(std::memory_order_relaxed) - shard.busy.load(std::memory_order_relaxed);
+    if (gap > policy->rebalance_threshold()) {
+        boost::asio::post(busiest->io_context, [this, &busy = *busiest, &idle = shard, gap] {
+            give_away(busy, idle, gap);
+        });
+    }
+}
+
+void ProxyServer::give_away(Shard& busy, Shard& idle, double gap) {
+    if (busy.stopped || idle.draining.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // A tunnel's share of the reactor is estimated from its share of the bytes. Moving a tunnel larger than the gap
+    // would leave the idle shard busier than the busy one was, so the largest tunnel that fits is taken.
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::uint64_t min_rate = (std::max)(policy_.load()->rebalance_min_rate(), std::uint64_t(1));
+    const double load_per_byte = busy.byte_rate.load(std::memory_order_relaxed) > 0
+        ? busy.busy.load(std::memory_order_relaxed) / static_cast<double>(busy.byte_rate.load(std::memory_order_relaxed)) : 0.0;
+    ProxySession* heaviest = nullptr;
+    busy.sessions.for_each([&](ProxySession& session) {
+        const std::uint64_t rate = session.relay_rate();
+        if (rate >= min_rate && static_cast<double>(rate) * load_per_byte < gap && session.migratable(now)
+            && (heaviest == nullptr || rate > heaviest->relay_rate())) {
+            heaviest = &session;
+        }
+    });
+    if (heaviest != nullptr) {
+        heaviest->migrate(idle);
+    }
 }
\ No newline at end of file
@@ -10,19 +10,44 @@
  */
 
 #pragma once
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <limits>
+#include <span>
+#include <utility>
 #include <boost/asio.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <boost/bind/bind.hpp>
 
 #include "Logger.h"
 #include "Handle_Authentication.h"
 #include "Database.h"
 #include "ProxyConfiguration.h"
+#include "IoContextPool.h"
+#include "SplicePipe.h"
+#include "UringRelay.h"
+#include "DnsCache.h"
+#include "HappyEyeballs.h"
+#include "Policy.h"
+#include "BufferPool.h"
+#include "RecyclingToken.h"
+#include "SessionRegistry.h"
+#include "TimingWheel.h"
+#include "AdmissionControl.h"
+#include "TokenBucket.h"
+#include "BandwidthShaper.h"
+#include "ListenerHandoff.h"
 
-const int BUFFER_SIZE = 4096;
 const int SOCKS_VERSION = 5;
+const int SOCKS_REQUEST_HEADER_SIZE = 5;
+const int SOCKS_REPLY_SIZE = 10;
 
 class ProxyServer {
 public:
@@ -41,103 +66,358 @@ public:
     ProxyServer(boost::asio::io_context& io_context, const std::string& ip_address, unsigned short port, const ProxyConfiguration& config, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database);
 
     /*
-     * Stops the proxy server by closing the acceptor and active sessions.
+     * Constructor for the ProxyServer class running one shard per io_context of the pool.
+     * Where SO_REUSEPORT is available every shard binds its own acceptor to the same endpoint
+     * and the kernel spreads incoming connections between them; otherwise a single acceptor
+     * hands accepted connections to the shards in round-robin order. If the configuration names a handoff
+     * socket, the listening sockets of a proxy process running there are taken over instead of bound anew,
+     * and handed on to the next process that asks for them.
+     *
+     * @param[in] pool: The pool of io_contexts, one per shard.
+     * @param[in] ip_address: The IP address to bind the proxy server to.
+     * @param[in] port: The port to listen on for incoming connections.
+     * @param[in] config: The ProxyConfiguration instance with proxy server configuration.
+     * @param[in] logging_method: The method used for logging (1 for database, 2 for both, and default for file).
+     * @param[in] logger: A shared_ptr to a Logger instance for logging.
+     * @param[in] database: A shared_ptr to a Database instance for database logging.
+     */
+    ProxyServer(IoContextPool& pool, const std::string& ip_address, unsigned short port, const ProxyConfiguration& config, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database);
+
+    /*
+     * Stops the proxy server by closing the acceptors and active sessions of every shard.
+     * The work is posted to each shard's io_context, so it is safe to call from any thread.
      */
     void stop();
 
+    /*
+     * Stops accepting and lets the sessions of every shard finish, closing those still open at the deadline.
+     * The work is posted to each shard's io_context, so it is safe to call from any thread.
+     *
+     * @param[in] timeout: The time the sessions get to finish; zero closes them at once.
+     * @param[in] drained: Called on the reactor thread of the last shard to drain; may be empty.
+     */
+    void drain(std::chrono::seconds timeout, std::function<void()> drained);
+
+    /*
+     * Sets the function called once a new process took the listening sockets over and the sessions of this one
+     * drained. Whoever creates the server must set it and let the io_contexts return there, typically by stopping
+     * the pool; without it the drained process keeps running. Must be set before the io_contexts run.
+     *
+     * @param[in] handler: The function, called on a reactor thread.
+     */
+    void set_handoff_handler(std::function<void()> handler);
+
+    /*
+     * Replaces the policy applied to new connections. Sessions already running keep the snapshot they started with.
+     * A policy that selects the io_uring engine opens the rings of the shards that have none yet. Safe to call from any thread.
+     *
+     * @param[in] policy: The new policy snapshot.
+     */
+    void update_policy(std::shared_ptr<const Policy> policy);
+
+    /*
+     * Get the policy applied to new connections.
+     *
+     * @return The current policy snapshot.
+     */
+    std::shared_ptr<const Policy> get_policy() const;
+
+    /*
+     * Get the number of sessions that are currently alive on all shards.
+     *
+     * @return The number of live sessions.
+     */
+    std::size_t session_count() const;
+
 private:
-    class ProxySession : public std::enable_shared_from_this<ProxySession> {
+    struct Shard;
+
+    class ProxySession : public std::enable_shared_from_this<ProxySession>, public SessionRegistry<ProxySession>::Hook, public TimingWheel<ProxySession>::Timer {
     public:
         /*
          * Constructor for the ProxySession class.
          *
          * @param[in] socket: The client socket connected to the proxy.
-         * @param[in] config: The ProxyConfiguration instance with proxy server configuration.
+         * @param[in] policy: The policy snapshot applied to the session.
          * @param[in] logging_method: The method used for logging (1 for database, 2 for both, and default for file).
          * @param[in] logger: A shared_ptr to a Logger instance for logging.
          * @param[in] database: A shared_ptr to a Database instance for database logging.
+         * @param[in] dns_cache: A shared_ptr to the process-wide DNS cache.
+         * @param[in] shaper: A shared_ptr to the process-wide bandwidth shaper.
+         * @param[in] shard: The shard that owns the session: its io_uring relay and timing wheel are used.
+         * @param[in] admission: The place of the session among the admitted ones.
          */
-        ProxySession(boost::asio::ip::tcp::socket socket, const ProxyConfiguration& config, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database);
+        ProxySession(boost::asio::ip::tcp::socket socket, const std::shared_ptr<const Policy> policy, const int logging_method, const std::shared_ptr<Logger> logger, const std::shared_ptr<Database> database, const std::shared_ptr<DnsCache> dns_cache, const std::shared_ptr<BandwidthShaper> shaper, Shard& shard, AdmissionControl::Ticket admission);
 
         /*
-         * Starts the proxy session by reading the SOCKS request.
+         * Starts the proxy session: spawns the coroutine running the handshake, which owns the session until the tunnel is relayed.
          */
         void start();
 
         /*
-         * Closes the proxy session by closing both client and server sockets.
+         * Closes the proxy session by closing both client and server sockets and removes it from the shard's registry.
          */
         void close();
 
+        /*
+         * Called by the timing wheel when the armed timeout has expired. Closes the session, unless it is
+         * an io_uring tunnel that relayed data since the last check, whose idle timeout is armed again.
+         */
+        void handle_timeout();
+
+        /*
+         * Computes the bytes per second the tunnel relayed since the previous call.
+         *
+         * @param[in] elapsed: The time since the previous call.
+         * @return The rate in bytes per second.
+         */
+        std::uint64_t sample_rate(std::chrono::steady_clock::duration elapsed);
+
+        /*
+         * Get whether the tunnel may be moved to another shard: it is relayed by the session itself, by copying or
+         * splicing, without bandwidth limits, and was not moved recently.
+         *
+         * @param[in] now: The current time.
+         * @return True if the tunnel may be moved.
+         */
+        bool migratable(std::chrono::steady_clock::time_point now) const;
+
+        /*
+         * Get the bytes per second the tunnel relayed in the last sample.
+         *
+         * @return The rate in bytes per second.
+         */
+        std::uint64_t relay_rate() const;
+
+        /*
+         * Moves the tunnel to another shard at the next point where neither direction has a read or write in
+         * flight. Both directions stop there and the sockets are handed to the io_context of the other shard,
+         * where the relay resumes.
+         *
+         * @param[in] target: The shard taking the tunnel over.
+         */
+        void migrate(Shard& target);
+
+        /*
+         * Drops a move that has not found a safe point yet; the tunnel stays on its shard.
+         */
+        void abandon_migration();
+
     private:
+        // What a direction of the relay is doing, so a move knows when its sockets are free to be handed over.
+        enum class Relay_State {
+            Idle,    // The direction is not relayed by the session.
+            Reading, // Waiting for the source to become readable; a move may cancel the wait.
+            Running, // Reading, writing or waiting for the destination.
+            Parked   // Stopped for a move.
+        };
+        // One direction of the copy relay: a ring of up to `depth` buffers, filled from the source whenever it is
+        // readable while a writer sends the filled ones to the destination with one gathered write at a time.
+        struct Copy_Relay {
+            struct Chunk {
+                BufferPool::Buffer buffer;
+                std::size_t size = 0;
+            };
+
+            std::unique_ptr<Chunk[]> chunks; // One per pipeline slot, allocated when the relay starts.
+            std::size_t depth = 0;
+            std::size_t head = 0; // Oldest filled chunk.
+            std::size_t filled = 0; // Chunks filled and not written yet, including those being written.
+            bool writing = false; // A writer is sending the filled chunks.
+            bool awaiting_data = false; // The reading side waits for the source to become readable.
+            bool failed = false; // A write failed and closed the session.
+            std::size_t buffer_size = 0; // Size of the next buffer, adapted to the flow.
+            unsigned small_reads = 0; // Consecutive reads that used less than a quarter of their buffer.
+        };
+
+        /*
+         * Runs the session up to the relay: authentication, the SOCKS request, connecting to the target and the reply.
+         * Every step is parsed from the handshake buffer, so a client may send its greeting, sub-negotiation, request
+         * and first payload without waiting for the replies; the payload is forwarded once the target is connected.
+         */
+        boost::asio::awaitable<void> run();
+
+        /*
+         * Waits until the handshake buffer holds at least `count` unparsed bytes, reading from the client only if they have not arrived yet.
+         *
+         * @param[in] count: The number of bytes needed.
+         * @return True if they were received, false if the client socket failed or was closed.
+         */
+        boost::asio::awaitable<bool> receive(std::size_t count);
+
+        /*
+         * Runs the authentication exchange: reads the client greeting, selects a method and runs its sub-negotiation.
+         *
+         * @return The result of the authentication.
+         */
+        boost::asio::awaitable<Authentication_Result> authenticate();
+
+        /*
+         * Handles the outcome of the authentication exchange.
+         *
+         * @param[in] result: The result of the authentication.
+         * @return True if the client may send its request, false if the session has to end.
+         */
+        bool handle_authentication(const Authentication_Result& result);
+
         /*
-         * Reads the initial SOCKS request from the client.
+         * Parses the SOCKS request received from the client and applies the policy to its target.
+         *
+         * @param[in] bytes_transferred: The number of bytes in the request.
+         * @param[out] address: The target host name or address literal.
+         * @param[out] port: The target port.
+         * @param[out] is_domain: Set if the target is a host name that has to be resolved.
+         * @return 0 if the target may be connected to, otherwise the SOCKS reply status refusing the request.
+         */
+        int handle_socks_request(std::size_t bytes_transferred, std::string& address, unsigned short& port, bool& is_domain);
+
+        /*
+         * Resolves a host name through the shared DNS cache.
+         *
+         * @param[in] hostname: The host name to resolve.
+         * @param[out] error: The error code of the lookup.
+         * @return The addresses the host name resolved to.
          */
-        void read_socks_request();
+        boost::asio::awaitable<std::shared_ptr<const DnsCache::Addresses>> resolve(const std::string& hostname, boost::system::error_code& error);
 
         /*
-         * Handles the SOCKS request received from the client.
+         * Connects to the first reachable target endpoint allowed by the policy, racing staggered attempts.
          *
-         * @param[in] error: The error code indicating the success or failure of the operation.
-         * @param[in] bytes_transferred: The number of bytes transferred in the request.
+         * @param[in] address: The target host name or address literal.
+         * @param[in] port: The target port.
+         * @param[in] is_domain: Set if the target is a host name that has to be resolved.
+         * @return 0 if connected, otherwise the SOCKS reply status to send.
          */
-        void handle_socks_request(const boost::system::error_code& error, std::size_t bytes_transferred);
+        boost::asio::awaitable<int> connect_to_target(const std::string& address, unsigned short port, bool is_domain);
 
         /*
-         * Handles the connection to the target server.
+         * Connects to the target after success has been reported to the client, buffering what the client sends
+         * in the meantime up to the policy's cap.
          *
-         * @param[in] error: The error code indicating the success or failure of the connection.
+         * @param[in] address: The target host name or address literal.
+         * @param[in] port: The target port.
+         * @param[in] is_domain: Set if the target is a host name that has to be resolved.
+         * @return 0 if connected, otherwise the SOCKS reply status the connect failed with.
          */
-        void handle_connect(const boost::system::error_code& error);
+        boost::asio::awaitable<int> connect_buffering(const std::string& address, unsigned short port, bool is_domain);
 
         /*
-         * Sends a SOCKS reply with the specified status code to the client.
+         * Writes the payload the client sent behind its request, or during an optimistic connect, to the connected target.
+         *
+         * @return 0 if it was written, otherwise the SOCKS reply status to send.
+         */
+        boost::asio::awaitable<int> forward_early_data();
+
+        /*
+         * Sends a SOCKS reply with the specified status code to the client. Closes the session if the reply cannot be written.
          *
          * @param[in] status: The SOCKS reply status code.
          */
-        void send_socks_reply(int status);
+        boost::asio::awaitable<void> send_socks_reply(int status);
+
+        /*
+         * Forwards data between the client and server, using the configured relay engine.
+         *
+         * @param[in] port: The target port, which decides the scheduling class of the tunnel.
+         */
+        void forward_data(unsigned short port);
+
+        /*
+         * Spawns the coroutines relaying both directions, through the pipes if the tunnel is spliced and by copying otherwise.
+         */
+        void spawn_relays();
+
+        /*
+         * Stops a direction for a move of the tunnel, unless the other direction may be writing to its source.
+         * The second direction to stop hands the tunnel over; the first one wakes the other if it waits for data.
+         *
+         * @param[in] state: The state of the stopping direction.
+         * @return True if the direction stopped and its coroutine has to end.
+         */
+        bool park(Relay_State& state);
+
+        /*
+         * Releases the sockets of a tunnel whose directions have both stopped and posts them to the target shard.
+         * The tunnel resumes on its shard if the sockets cannot be released.
+         */
+        void hand_over();
+
+        /*
+         * Takes over a tunnel handed over by another shard: registers the session, adopts the sockets and resumes the relay.
+         * Must run on the io_context of the target shard.
+         *
+         * @param[in] target: The shard taking the tunnel over.
+         * @param[in] client: The protocol and descriptor of the client socket.
+         * @param[in] server: The protocol and descriptor of the server socket.
+         */
+        void take_over(Shard& target, std::pair<boost::asio::ip::tcp, boost::asio::ip::tcp::socket::native_handle_type> client, std::pair<boost::asio::ip::tcp, boost::asio::ip::tcp::socket::native_handle_type> server);
+
+        /*
+         * Starts relaying both directions through kernel pipes with splice(2).
+         *
+         * @return True if the splice relay was started, false if the session has to fall back to copying.
+         */
+        bool start_splice_relay();
 
         /*
-         * Handles the completion of write operations to the client socket.
+         * Hands both directions of the tunnel to the shard's io_uring relay.
          *
-         * @param[in] error: The error code indicating the success or failure of the write operation.
+         * @return True if the io_uring relay was started, false if the session has to fall back to copying.
          */
-        void handle_write(const boost::system::error_code& error);
+        bool start_uring_relay();
 
         /*
-         * Forwards data between the client and server.
+         * Relays one direction through a pipe: waits until the source is readable, moves the available data into
+         * the pipe and drains it to the destination, waiting for it to become writable as needed. Closes the session when it ends.
+         *
+         * @param[in] state: The state of this direction.
+         * @param[in] pipe: The pipe buffering this direction.
+         * @param[in] source: The socket data is read from.
+         * @param[in] destination: The socket data is written to.
          */
-        void forward_data();
+        boost::asio::awaitable<void> splice_relay(Relay_State& state, SplicePipe& pipe, boost::asio::ip::tcp::socket& source, boost::asio::ip::tcp::socket& destination);
 
         /*
-         * Handles read operations from the client socket.
+         * Relays one direction by copying: waits until the source is readable, checks buffers out of the pool and
+         * fills as many free chunks as the socket has data for, and starts a writer for them. Reading goes on while
+         * the writer sends the older chunks and waits only once all `depth` chunks are filled. Closes the session when it ends.
          *
-         * @param[in] error: The error code indicating the success or failure of the read operation.
-         * @param[in] bytes_transferred: The number of bytes transferred in the read operation.
+         * @param[in] state: The state of this direction.
+         * @param[in] relay: The buffers of this direction.
+         * @param[in] source: The socket data is read from.
+         * @param[in] destination: The socket data is written to.
          */
-        void handle_client_read(const boost::system::error_code& error, std::size_t bytes_transferred);
+        boost::asio::awaitable<void> copy_relay(Relay_State& state, Copy_Relay& relay, boost::asio::ip::tcp::socket& source, boost::asio::ip::tcp::socket& destination);
 
         /*
-         * Handles read operations from the server socket.
+         * Writes the filled chunks of a direction to the destination until none is left, each time all of them with
+         * one gathered write, and returns them to the pool. Wakes the reading side after every write.
          *
-         * @param[in] error: The error code indicating the success or failure of the read operation.
-         * @param[in] bytes_transferred: The number of bytes transferred in the read operation.
+         * @param[in] state: The state of this direction.
+         * @param[in] relay: The buffers of this direction.
+         * @param[in] wake: The timer the reading side waits on.
+         * @param[in] destination: The socket data is written to.
          */
-        void handle_server_read(const boost::system::error_code& error, std::size_t bytes_transferred);
+        boost::asio::awaitable<void> copy_write(Relay_State& state, Copy_Relay& relay, boost::asio::steady_timer& wake, boost::asio::ip::tcp::socket& destination);
 
         /*
-         * Handles write operations to the server socket.
+         * Adapts the buffer size of a direction to its flow: a read that fills its buffer grows the size
+         * towards the policy maximum, a run of reads that barely use it shrinks the size towards the minimum.
          *
-         * @param[in] error: The error code indicating the success or failure of the write operation.
+         * @param[in] relay: The state of this direction.
+         * @param[in] bytes: The number of bytes the last read returned.
+         * @param[in] capacity: The size of the buffer the last read used.
          */
-        void handle_server_write(const boost::system::error_code& error);
+        void adapt_buffer_size(Copy_Relay& relay, std::size_t bytes, std::size_t capacity);
 
         /*
-         * Handles write operations to the client socket.
+         * Waits until the bandwidth limits of the session allow relaying more data. Sessions without limits never wait.
          *
-         * @param[in] error: The error code indicating the success or failure of the write operation.
+         * @param[in] pause: The timer of the waiting direction.
+         * @param[in] source: The socket of the waiting direction; the wait ends early once it is closed.
+         * @return The number of bytes the direction may read, zero if the socket was closed.
          */
-        void handle_client_write(const boost::system::error_code& error);
+        boost::asio::awaitable<std::size_t> wait_for_budget(boost::asio::steady_timer& pause, boost::asio::ip::tcp::socket& source);
 
         /*
          * Logs a message to the appropriate log destination based on the logging method.
@@ -148,29 +428,200 @@ private:
          */
         void log_to_file(const spdlog::level::level_enum log_level, const std::string& IP, const std::string& message);
 
+        /*
+         * Arms the timeout of the current phase of the session, replacing the previous one.
+         *
+         * @param[in] timeout: The timeout; zero disarms it.
+         * @param[in] phase: The name of the phase, logged when the timeout expires.
+         */
+        void arm_timeout(std::chrono::seconds timeout, const char* phase);
+
         boost::asio::ip::tcp::socket client_socket_;
         boost::asio::ip::tcp::socket server_socket_;
-        char client_data_[BUFFER_SIZE];
-        char server_data_[BUFFER_SIZE];
-        ProxyConfiguration proxyConfig_;
+        std::string client_ip_;
+        Handshake_Buffer handshake_; // Receives the handshake; released once the tunnel is established.
+        Copy_Relay client_relay_; // Client to server direction of the copy relay.
+        Copy_Relay server_relay_; // Server to client direction of the copy relay.
+        char reply_data_[SOCKS_REPLY_SIZE];
+        std::shared_ptr<const Policy> policy_;
         int logging_method_;
         std::shared_ptr<Logger> logger_;
         std::shared_ptr<Database> database_;
-        std::shared_ptr<boost::asio::ip::tcp::socket> client_socket_ptr_;
+        std::shared_ptr<DnsCache> dns_cache_;
+        std::shared_ptr<BandwidthShaper> shaper_;
+        BandwidthShaper::Chain shaping_; // The buckets the relayed bytes are charged to.
+        std::size_t relay_quantum_; // Bytes a direction relays per scheduling round.
+        std::string username_; // The authenticated user, empty if the method has none.
+        std::shared_ptr<HappyEyeballs> connector_; // The connection race in flight, cancelled when the session closes.
+        std::unique_ptr<SplicePipe> client_pipe_; // Client to server direction of the splice relay.
+        std::unique_ptr<SplicePipe> server_pipe_; // Server to client direction of the splice relay.
+        Shard* shard_; // The shard the session runs on.
+        UringRelay::Tunnel_Id uring_tunnel_; // The tunnel relayed by io_uring, or 0.
+        std::uint64_t uring_activity_; // Chunks the io_uring tunnel had received when its idle timeout was last checked.
+        const char* timeout_phase_; // Handshake, connect or idle.
+        Relay_State client_state_; // Client to server direction.
+        Relay_State server_state_; // Server to client direction.
+        Shard* migration_; // The shard the tunnel is moving to, or nullptr.
+        std::chrono::steady_clock::time_point migrated_at_; // When the tunnel was last moved or a move failed.
+        std::uint64_t relayed_bytes_; // Bytes relayed by the session in both directions.
+        std::uint64_t sampled_bytes_; // Bytes relayed when the rate was last sampled.
+        std::uint64_t relay_rate_; // Bytes per second in the last sample.
+        AdmissionControl::Ticket admission_; // Released when the session closes.
+    };
+
+    // A single reactor together with the acceptor and sessions it owns.
+    struct Shard {
+        explicit Shard(boost::asio::io_context& io_context);
+
+        boost::asio::io_context& io_context;
+        boost::asio::ip::tcp::acceptor acceptor;
+        std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> surplus_acceptors; // Listening sockets taken over beyond one per shard.
+        std::unique_ptr<UringRelay> uring_relay; // Relays the tunnels of the shard when the io_uring engine is selected.
+        SessionRegistry<ProxySession> sessions; // Live sessions, owned by their pending handlers.
+        TimingWheel<ProxySession> timeouts; // Handshake, connect and idle timeouts of the sessions.
+        TokenBucket accept_rate; // This acceptor's share of the accept rate.
+        boost::asio::steady_timer accept_timer; // Resumes accepting after the process ran out of file descriptors.
+        std::vector<boost::asio::ip::tcp::acceptor*> paused_accepts; // Acceptors of the accepts waiting for accept_timer.
+        boost::asio::steady_timer rebalance_timer; // Samples the load of the shard and takes tunnels over from busier ones.
+        std::chrono::steady_clock::time_point sampled_at; // When the load was last sampled.
+        std::chrono::nanoseconds cpu_time{ 0 }; // CPU time of the reactor thread at the last sample.
+        std::atomic<double> busy{ 0.0 }; // Share of the last interval the reactor thread spent running handlers.
+        std::atomic<std::uint64_t> byte_rate{ 0 }; // Bytes per second the shard's tunnels relayed in the last interval.
+        std::atomic<bool> draining{ false }; // Set once the shard stopped accepting; its load is no longer sampled and it takes no tunnels over.
+        bool stopped = false; // Set once the server stopped; tunnels moved here are closed.
+    };
+
+    // A drain in progress, shared by the shards taking part in it.
+    struct Drain {
+        std::atomic<std::size_t> pending_shards; // Shards that still have sessions.
+        std::chrono::steady_clock::time_point deadline; // When the remaining sessions are closed.
+        std::function<void()> drained;
     };
 
     /*
-     * Starts accepting incoming client connections asynchronously.
+     * Opens the acceptors of the shards on the given endpoint and starts accepting. The listening sockets of a
+     * process running on the handoff socket are adopted first, and then offered to the next one.
+     *
+     * @param[in] ip_address: The IP address to bind the proxy server to.
+     * @param[in] port: The port to listen on for incoming connections.
+     * @param[in] handoff_path: The path of the handoff socket, empty if listening sockets are not handed over.
+     */
+    void open_acceptors(const std::string& ip_address, unsigned short port, const std::string& handoff_path);
+
+    /*
+     * Creates an io_uring relay for every shard if the policy selects that engine, or leaves the shards on the copy relay if the kernel lacks io_uring.
+     */
+    void open_uring_relays();
+
+    /*
+     * Starts accepting incoming client connections asynchronously on one of a shard's acceptors.
+     *
+     * @param[in] shard: The shard that owns the acceptor.
+     * @param[in] acceptor: The shard's acceptor or one of its surplus acceptors.
+     */
+    void start_accept(Shard& shard, boost::asio::ip::tcp::acceptor& acceptor);
+
+    /*
+     * Stops one of a shard's accepts for a while. Used when accepting fails for lack of descriptors or memory,
+     * which would otherwise fail again right away for as long as the connection waits in the backlog.
+     *
+     * @param[in] shard: The shard that owns the acceptor.
+     * @param[in] acceptor: The acceptor that failed.
+     */
+    void pause_accept(Shard& shard, boost::asio::ip::tcp::acceptor& acceptor);
+
+    /*
+     * Accepts the connections waiting in the backlog of a listening socket taken over for an endpoint that is
+     * no longer configured, then closes it. Must run on the shard's io_context, after the previous process
+     * was told to stop accepting.
+     *
+     * @param[in] shard: The shard whose io_context the socket belongs to, which owns the sessions.
+     * @param[in] listener: The listening socket.
+     */
+    void retire_listener(Shard& shard, boost::asio::ip::tcp::acceptor listener);
+
+    /*
+     * Closes a shard's acceptors and stops sampling its load. Must run on the shard's io_context.
+     *
+     * @param[in] shard: The shard.
+     */
+    void stop_accepting(Shard& shard);
+
+    /*
+     * Checks a draining shard for live sessions until none are left or the deadline passed, closes the remaining
+     * ones and reports the shard as drained. Sessions do not report closing, so the registry is polled.
+     * Must run on the shard's io_context.
+     *
+     * @param[in] shard: The draining shard.
+     * @param[in] drain: The drain the shard takes part in.
+     */
+    void await_drain(Shard& shard, std::shared_ptr<Drain> drain);
+
+    /*
+     * Checks an accepted connection against the accept rate of the shard and the session caps, and rejects it if
+     * it is over any of them.
+     *
+     * @param[in] shard: The shard whose acceptor accepted the connection.
+     * @param[in] socket: The accepted client socket, closed if the connection is rejected.
+     * @param[out] ticket: Receives the place of the session if the connection is admitted.
+     * @return True if the connection is admitted.
+     */
+    bool admit(Shard& shard, boost::asio::ip::tcp::socket& socket, AdmissionControl::Ticket& ticket);
+
+    /*
+     * Rejects a connection without creating a session: answers the greeting with "no acceptable methods"
+     * or resets the connection, as the policy says, and closes the socket.
+     *
+     * @param[in] socket: The client socket.
+     * @param[in] policy: The current policy.
+     */
+    void reject(boost::asio::ip::tcp::socket& socket, const Policy& policy);
+
+    /*
+     * Creates a session for an accepted client and starts it. Must run on the shard's io_context.
+     *
+     * @param[in] shard: The shard that owns the session.
+     * @param[in] socket: The accepted client socket.
+     * @param[in] admission: The place of the session among the admitted ones.
+     */
+    void start_session(Shard& shard, boost::asio::ip::tcp::socket socket, AdmissionControl::Ticket admission);
+
+    /*
+     * Waits for the next load sample of a shard, re-reading the interval from the current policy.
+     *
+     * @param[in] shard: The shard to sample.
+     */
+    void schedule_rebalance(Shard& shard);
+
+    /*
+     * Samples the load of a shard: the CPU time its reactor thread spent running handlers and the bytes its tunnels
+     * relayed since the previous sample. If another shard is busier by more than the threshold, asks it for a tunnel.
+     * Must run on the shard's io_context.
+     *
+     * @param[in] shard: The shard to sample.
+     */
+    void rebalance(Shard& shard);
+
+    /*
+     * Moves the heaviest tunnel of a busy shard that fits the difference in load to an idle shard. Must run on the
+     * io_context of the busy shard.
      *
-     * @param[in] socket: A shared_ptr to the server socket.
+     * @param[in] busy: The shard giving a tunnel away.
+     * @param[in] idle: The shard asking for it.
+     * @param[in] gap: The difference in busy time between the shards when the idle one asked.
      */
-    void start_accept(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+    void give_away(Shard& busy, Shard& idle, double gap);
 
-    boost::asio::ip::tcp::acceptor acceptor_;
-    std::shared_ptr<boost::asio::ip::tcp::socket> socket_;
-    ProxyConfiguration proxyConfig_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t next_shard_;
+    std::size_t acceptor_count_; // Acceptors sharing the accept rate.
+    AdmissionControl admission_;
+    std::atomic<std::shared_ptr<const Policy>> policy_;
     int logging_method_;
     std::shared_ptr<Logger> logger_;
     std::shared_ptr<Database> database_;
-    std::vector<std::shared_ptr<ProxySession>> active_sessions_;
+    std::shared_ptr<DnsCache> dns_cache_;
+    std::shared_ptr<BandwidthShaper> shaper_;
+    std::unique_ptr<ListenerHandoff> handoff_; // Hands the listening sockets to a successor, on the first shard.
+    std::function<void()> handoff_handler_;
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+/*
+ * RecyclingToken.h
+ * Purpose: Completion token adapter that allocates the handlers of asynchronous operations from the calling
+ *          thread's BufferPool. Boost.Asio keeps a single recycled block per thread for handler memory, which
+ *          a shard with many sessions in flight keeps missing because operations of different sizes complete
+ *          in between; the pool caches blocks per size class, so a relay loop does not allocate per operation.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <type_traits>
+#include <utility>
+#include <boost/asio.hpp>
+
+#include "BufferPool.h"
+
+// Completion handler forwarding to the wrapped handler, with BufferPool as its associated allocator.
+template <typename Handler>
+class Recycling_Handler {
+public:
+    explicit Recycling_Handler(Handler handler)
+        : handler_(std::move(handler)) {
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        std::move(handler_)(std::forward<Args>(args)...);
+    }
+
+    const Handler& handler() const {
+        return handler_;
+    }
+
+private:
+    Handler handler_;
+};
+
+// Completion token wrapping another token, e.g. `use_awaitable`, whose handlers are allocated from BufferPool.
+template <typename Token>
+struct Recycling_Token {
+    Token token;
+};
+
+/*
+ * Wraps a completion token so that the handlers of the operation are allocated from the calling thread's BufferPool.
+ *
+ * @param[in] token: The completion token to wrap.
+ * @return The wrapping token.
+ */
+template <typename Token>
+Recycling_Token<std::decay_t<Token>> recycling(Token&& token) {
+    return { std::forward<Token>(token) };
+}
+
+namespace boost {
+namespace asio {
+
+template <typename Token, typename Signature>
+struct async_result<Recycling_Token<Token>, Signature> {
+    using return_type = typename async_result<Token, Signature>::return_type;
+
+    // Hands the operation a Recycling_Handler around the handler the wrapped token creates.
+    template <typename Initiation>
+    struct Init_Wrapper {
+        template <typename Handler, typename... Args>
+        void operator()(Handler&& handler, Args&&... args) {
+            std::move(initiation)(Recycling_Handler<std::decay_t<Handler>>(std::forward<Handler>(handler)), std::forward<Args>(args)...);
+        }
+
+        Initiation initiation;
+    };
+
+    template <typename Initiation, typename RawToken, typename... Args>
+    static return_type initiate(Initiation&& initiation, RawToken&& token, Args&&... args) {
+        Token inner = token.token;
+        return async_initiate<Token, Signature>(
+            Init_Wrapper<std::decay_t<Initiation>>{ std::forward<Initiation>(initiation) },
+            inner, std::forward<Args>(args)...);
+    }
+};
+
+template <typename Handler, typename Allocator>
+struct associated_allocator<Recycling_Handler<Handler>, Allocator> {
+    using type = BufferPool::Allocator<void>;
+
+    static type get(const Recycling_Handler<Handler>&, const Allocator& = Allocator()) noexcept {
+        return type();
+    }
+};
+
+template <typename Handler, typename Executor>
+struct associated_executor<Recycling_Handler<Handler>, Executor> {
+    using type = typename associated_executor<Handler, Executor>::type;
+
+    static type get(const Recycling_Handler<Handler>& handler, const Executor& executor = Executor()) noexcept {
+        return associated_executor<Handler, Executor>::get(handler.handler(), executor);
+    }
+};
+
+} // namespace asio
+} // namespace boost
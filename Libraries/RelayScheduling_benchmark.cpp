@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "./Logger.h"
+#include "./ProxyConfiguration.h"
+#include "./ProxyServer.h"
+
+using boost::asio::ip::tcp;
+
+// Target servers on loopback, one thread per connection: the sink discards everything, the echo server returns it.
+struct Target
+{
+    Target(bool echo)
+        : acceptor(io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)), echo(echo)
+    {
+        thread = std::thread([this] {
+            while (true)
+            {
+                auto socket = std::make_shared<tcp::socket>(io_context);
+                boost::system::error_code error;
+                acceptor.accept(*socket, error);
+                if (error)
+                {
+                    return;
+                }
+                connections.emplace_back([socket, echo = this->echo] {
+                    std::vector<char> buffer(1024 * 1024);
+                    boost::system::error_code error;
+                    while (!error)
+                    {
+                        const std::size_t length = socket->read_some(boost::asio::buffer(buffer), error);
+                        if (!error && echo)
+                        {
+                            boost::asio::write(*socket, boost::asio::buffer(buffer.data(), length), error);
+                        }
+                    }
+                });
+            }
+        });
+    }
+
+    ~Target()
+    {
+        // Shutting the listening socket down wakes the blocked accept.
+        ::shutdown(acceptor.native_handle(), SHUT_RDWR);
+        boost::system::error_code ignored;
+        acceptor.close(ignored);
+        thread.join();
+        for (std::thread& connection : connections)
+        {
+            connection.join();
+        }
+    }
+
+    unsigned short port() const
+    {
+        return acceptor.local_endpoint().port();
+    }
+
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor;
+    bool echo;
+    std::thread thread;
+    std::vector<std::thread> connections;
+};
+
+// Opens a tunnel through the proxy with a CONNECT request to a loopback port.
+tcp::socket open_tunnel(boost::asio::io_context& io_context, unsigned short proxy_port, unsigned short target_port)
+{
+    tcp::socket socket(io_context);
+    socket.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), proxy_port));
+    socket.set_option(tcp::no_delay(true));
+
+    const unsigned char request[] = { 0x05, 0x01, 0x00,
+        0x05, 0x01, 0x00, 0x01, 127, 0, 0, 1, static_cast<unsigned char>(target_port >> 8), static_cast<unsigned char>(target_port & 0xFF) };
+    boost::asio::write(socket, boost::asio::buffer(request));
+    unsigned char reply[2 + 10];
+    boost::asio::read(socket, boost::asio::buffer(reply));
+    if (reply[1] != 0x00 || reply[3] != 0x00)
+    {
+        throw std::runtime_error("The proxy refused the tunnel.");
+    }
+    return socket;
+}
+
+unsigned short free_port()
+{
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor(io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    return acceptor.local_endpoint().port();
+}
+
+// Runs bulk tunnels alongside one request/response tunnel through a single reactor and reports the round trip
+// latency of the small requests and the throughput of the bulk tunnels.
+void run(const char* name, int quantum, std::size_t bulk_count, std::size_t request_count)
+{
+    Target sink(false);
+    Target echo(true);
+
+    ProxyConfiguration config;
+    config.addAllowedIP("all");
+    config.addAllowedPort(-1);
+    config.setAuthenticationMethod(0);
+    config.setRelayEngine(0);
+    config.setRelayQuantum(quantum);
+
+    boost::asio::io_context io_context;
+    const unsigned short proxy_port = free_port();
+    auto logger = std::make_shared<Logger>(1, "RelayScheduling_benchmark.log");
+    ProxyServer server(io_context, "127.0.0.1", proxy_port, config, 0, logger, nullptr);
+    std::thread reactor([&io_context] { io_context.run(); });
+
+    boost::asio::io_context client_context;
+    std::atomic<bool> running(true);
+    std::atomic<std::uint64_t> bulk_bytes(0);
+    std::vector<std::thread> senders;
+    for (std::size_t i = 0; i < bulk_count; i++)
+    {
+        senders.emplace_back([&, socket = std::make_shared<tcp::socket>(open_tunnel(client_context, proxy_port, sink.port()))] {
+            const std::vector<char> chunk(1024 * 1024, 'x');
+            boost::system::error_code error;
+            while (running && !error)
+            {
+                bulk_bytes += boost::asio::write(*socket, boost::asio::buffer(chunk), error);
+            }
+            socket->close(error);
+        });
+    }
+
+    // Lets the bulk tunnels reach their full buffer sizes before measuring.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const std::uint64_t bytes_start = bulk_bytes;
+    const auto start = std::chrono::steady_clock::now();
+
+    tcp::socket requests = open_tunnel(client_context, proxy_port, echo.port());
+    std::vector<double> latencies;
+    char message[64] = {};
+    for (std::size_t i = 0; i < request_count; i++)
+    {
+        const auto sent = std::chrono::steady_clock::now();
+        boost::asio::write(requests, boost::asio::buffer(message));
+        boost::asio::read(requests, boost::asio::buffer(message));
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double throughput = (bulk_bytes - bytes_start) / seconds / 1e6;
+    running = false;
+    requests.close();
+    for (std::thread& sender : senders)
+    {
+        sender.join();
+    }
+    server.stop();
+    boost::asio::post(io_context, [&io_context] { io_context.stop(); });
+    reactor.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))];
+    };
+    std::cout << name << ", " << bulk_count << " bulk tunnel(s): small flow p50 " << percentile(0.5) << " us, p99 "
+        << percentile(0.99) << " us, max " << latencies.back() << " us; bulk " << throughput << " MB/s" << std::endl;
+}
+
+int main()
+{
+    const std::size_t request_count = 5000;
+
+    for (std::size_t bulk_count : { 0, 8, 32 })
+    {
+        run("Unscheduled", 0, bulk_count, request_count);
+        run("Quantum 64 KiB", 65536, bulk_count, request_count);
+        run("Quantum 16 KiB", 16384, bulk_count, request_count);
+    }
+
+    return 0;
+}
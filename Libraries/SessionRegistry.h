@@ -0,0 +1,137 @@
+/*
+ * SessionRegistry.h
+ * Purpose: Intrusive list of the sessions that are alive on one shard.
+ *          Sessions embed their own list hook, so linking and unlinking are O(1) and never allocate.
+ *          The registry does not own its sessions: they are kept alive by their pending handlers and
+ *          unlink themselves when they close or are destroyed. A registry is used from the thread of its
+ *          shard only; the live count may be read from any thread.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+template <typename T>
+class SessionRegistry {
+public:
+    // Base class embedding the list links in every registered session.
+    class Hook {
+    public:
+        Hook() = default;
+
+        // Delete copy constructor to prevent unintended copying.
+        Hook(const Hook&) = delete;
+
+        /*
+         * Destructor. Unlinks the session if it is still registered.
+         */
+        ~Hook() {
+            unlink();
+        }
+
+        // Delete assignment operator to prevent unintended copying.
+        Hook& operator = (const Hook&) = delete;
+
+        /*
+         * Removes the session from its registry. Safe to call more than once.
+         */
+        void unlink() {
+            if (registry_ != nullptr) {
+                registry_->remove(this);
+            }
+        }
+
+    private:
+        friend class SessionRegistry;
+
+        SessionRegistry* registry_ = nullptr;
+        Hook* previous_ = nullptr;
+        Hook* next_ = nullptr;
+    };
+
+    SessionRegistry() = default;
+
+    // Delete copy constructor to prevent unintended copying.
+    SessionRegistry(const SessionRegistry&) = delete;
+
+    /*
+     * Destructor. Detaches the sessions that are still registered, so they do not unlink from a destroyed registry.
+     */
+    ~SessionRegistry() {
+        Hook* hook = head_;
+        while (hook != nullptr) {
+            Hook* next = hook->next_;
+            hook->registry_ = nullptr;
+            hook->previous_ = nullptr;
+            hook->next_ = nullptr;
+            hook = next;
+        }
+    }
+
+    // Delete assignment operator to prevent unintended copying.
+    SessionRegistry& operator = (const SessionRegistry&) = delete;
+
+    /*
+     * Adds a session to the registry.
+     *
+     * @param[in] session: The session, which must not be registered yet.
+     */
+    void add(T& session) {
+        Hook* hook = &session;
+        hook->registry_ = this;
+        hook->previous_ = nullptr;
+        hook->next_ = head_;
+        if (head_ != nullptr) {
+            head_->previous_ = hook;
+        }
+        head_ = hook;
+        size_.store(size_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /*
+     * Calls a function for every registered session. The function may unlink the session it is given.
+     *
+     * @param[in] function: The function to call.
+     */
+    template <typename Function>
+    void for_each(Function&& function) {
+        Hook* hook = head_;
+        while (hook != nullptr) {
+            Hook* next = hook->next_;
+            function(static_cast<T&>(*hook));
+            hook = next;
+        }
+    }
+
+    /*
+     * Get the number of registered sessions. Safe to call from any thread.
+     *
+     * @return The number of live sessions.
+     */
+    std::size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void remove(Hook* hook) {
+        if (hook->previous_ != nullptr) {
+            hook->previous_->next_ = hook->next_;
+        }
+        else {
+            head_ = hook->next_;
+        }
+        if (hook->next_ != nullptr) {
+            hook->next_->previous_ = hook->previous_;
+        }
+        hook->registry_ = nullptr;
+        hook->previous_ = nullptr;
+        hook->next_ = nullptr;
+        size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+
+    Hook* head_ = nullptr;
+    std::atomic<std::size_t> size_{ 0 };
+};
@@ -0,0 +1,67 @@
+/*
+ * SplicePipe.h
+ * Purpose: Kernel pipe used to move relayed data between two sockets with splice(2),
+ *          so the payload of an established tunnel never has to be copied into user space.
+ *          Only available on Linux; elsewhere open() fails and callers fall back to copying.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <boost/asio.hpp>
+
+class SplicePipe {
+public:
+    SplicePipe();
+
+    // Delete copy constructor to prevent closing the pipe twice.
+    SplicePipe(const SplicePipe&) = delete;
+
+    /*
+     * Destructor. Closes both ends of the pipe.
+     */
+    ~SplicePipe();
+
+    // Delete assignment operator to prevent closing the pipe twice.
+    SplicePipe& operator = (const SplicePipe&) = delete;
+
+    /*
+     * Creates the non-blocking pipe.
+     *
+     * @return True if the pipe was created, false if splice relaying is unavailable.
+     */
+    bool open();
+
+    /*
+     * Moves data that is ready on the socket into the pipe.
+     *
+     * @param[in] socket: The non-blocking socket to read from.
+     * @param[in] limit: The maximum number of bytes to move.
+     * @param[out] error: Set to `would_block` when the socket has no data and to `eof` when it was closed by the peer.
+     * @return The number of bytes moved into the pipe.
+     */
+    std::size_t fill(boost::asio::ip::tcp::socket& socket, std::size_t limit, boost::system::error_code& error);
+
+    /*
+     * Moves data buffered in the pipe out to the socket.
+     *
+     * @param[in] socket: The non-blocking socket to write to.
+     * @param[out] error: Set to `would_block` when the socket cannot accept more data.
+     * @return The number of bytes moved out of the pipe.
+     */
+    std::size_t drain(boost::asio::ip::tcp::socket& socket, boost::system::error_code& error);
+
+    /*
+     * Get the number of bytes buffered in the pipe.
+     *
+     * @return The number of bytes waiting to be drained.
+     */
+    std::size_t pending() const;
+
+private:
+    int read_fd_;
+    int write_fd_;
+    std::size_t capacity_;
+    std::size_t pending_;
+};
@@ -0,0 +1,243 @@
+/*
+ * TimingWheel.h
+ * Purpose: Hashed timing wheel driving the timeouts of the sessions of one shard with a single timer.
+ *          Objects embed their own wheel links, so arming, re-arming and disarming are O(1) and never
+ *          allocate. Activity is recorded with touch(), which only stores the current tick: an armed
+ *          timeout is moved forward lazily when its slot comes up, so a busy relay pays nothing per chunk.
+ *          The wheel only ticks while something is armed. A wheel is used from the thread of its shard only.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/asio.hpp>
+
+template <typename T>
+class TimingWheel {
+public:
+    // Default resolution of the wheel and number of slots, which span about eight and a half minutes.
+    static constexpr std::chrono::milliseconds DEFAULT_TICK{ 1000 };
+    static constexpr std::size_t DEFAULT_SLOT_COUNT = 512;
+
+    // Base class embedding the wheel links in every object with a timeout. The wheel calls `handle_timeout()` of the object.
+    class Timer {
+    public:
+        Timer() = default;
+
+        // Delete copy constructor to prevent unintended copying.
+        Timer(const Timer&) = delete;
+
+        /*
+         * Destructor. Disarms the timeout if it is still armed.
+         */
+        ~Timer() {
+            disarm();
+        }
+
+        // Delete assignment operator to prevent unintended copying.
+        Timer& operator = (const Timer&) = delete;
+
+        /*
+         * Records activity: the armed timeout counts from now on. Does nothing if no timeout is armed.
+         */
+        void touch() {
+            if (wheel_ != nullptr) {
+                last_activity_ = wheel_->current_tick_;
+            }
+        }
+
+        /*
+         * Removes the timeout from its wheel. Safe to call more than once.
+         */
+        void disarm() {
+            if (wheel_ != nullptr) {
+                wheel_->remove(this);
+            }
+        }
+
+    private:
+        friend class TimingWheel;
+
+        TimingWheel* wheel_ = nullptr;
+        Timer* previous_ = nullptr;
+        Timer* next_ = nullptr;
+        std::size_t slot_ = 0;
+        std::uint64_t deadline_ = 0; // Tick the timeout is due at, unless there was activity since.
+        std::uint64_t last_activity_ = 0;
+        std::uint64_t timeout_ = 0; // In ticks.
+    };
+
+    /*
+     * Constructor for the TimingWheel class.
+     *
+     * @param[in] io_context: The io_context of the shard.
+     * @param[in] tick: The resolution of the wheel.
+     * @param[in] slot_count: The number of slots. Timeouts longer than the wheel spans are checked once per revolution.
+     */
+    explicit TimingWheel(boost::asio::io_context& io_context, std::chrono::milliseconds tick = DEFAULT_TICK, std::size_t slot_count = DEFAULT_SLOT_COUNT)
+        : timer_(io_context),
+        tick_(tick),
+        slots_(slot_count + 1, nullptr),
+        slot_count_(slot_count) {
+    }
+
+    // Delete copy constructor to prevent unintended copying.
+    TimingWheel(const TimingWheel&) = delete;
+
+    /*
+     * Destructor. Detaches the objects that are still armed, so they do not disarm from a destroyed wheel.
+     */
+    ~TimingWheel() {
+        for (Timer* head : slots_) {
+            while (head != nullptr) {
+                Timer* next = head->next_;
+                head->wheel_ = nullptr;
+                head->previous_ = nullptr;
+                head->next_ = nullptr;
+                head = next;
+            }
+        }
+    }
+
+    // Delete assignment operator to prevent unintended copying.
+    TimingWheel& operator = (const TimingWheel&) = delete;
+
+    /*
+     * Arms or re-arms the timeout of an object, replacing the one it had.
+     *
+     * @param[in] object: The object.
+     * @param[in] timeout: The time without activity after which the object's `handle_timeout()` is called, rounded up to whole ticks.
+     */
+    void arm(T& object, std::chrono::steady_clock::duration timeout) {
+        Timer* timer = &object;
+        timer->disarm();
+
+        const std::uint64_t ticks = static_cast<std::uint64_t>((timeout + tick_ - std::chrono::steady_clock::duration(1)) / tick_);
+        timer->timeout_ = ticks > 0 ? ticks : 1;
+        timer->last_activity_ = current_tick_;
+        link(timer, current_tick_ + timer->timeout_);
+
+        if (!running_) {
+            // The wheel stood still while nothing was armed; it resumes counting from now.
+            running_ = true;
+            next_tick_time_ = std::chrono::steady_clock::now() + tick_;
+            wait();
+        }
+    }
+
+    /*
+     * Get the number of armed timeouts.
+     *
+     * @return The number of armed timeouts.
+     */
+    std::size_t size() const {
+        return size_;
+    }
+
+private:
+    /*
+     * Waits for the next tick.
+     */
+    void wait() {
+        timer_.expires_at(next_tick_time_);
+        timer_.async_wait([this](const boost::system::error_code& error) {
+            if (error) {
+                return;
+            }
+            advance();
+        });
+    }
+
+    /*
+     * Processes every tick that has passed, then waits for the next one while timeouts are armed.
+     */
+    void advance() {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        while (next_tick_time_ <= now) {
+            ++current_tick_;
+            next_tick_time_ += tick_;
+            expire(static_cast<std::size_t>(current_tick_ % slot_count_));
+        }
+
+        if (size_ > 0) {
+            wait();
+        }
+        else {
+            running_ = false;
+        }
+    }
+
+    /*
+     * Handles the timeouts in a slot that are due: re-links those with activity since they were armed and expires the rest.
+     *
+     * @param[in] slot: The slot of the current tick.
+     */
+    void expire(std::size_t slot) {
+        // The slot is moved to the expiring list first, so timeouts re-linked into the same slot are not visited again.
+        Timer* head = slots_[slot];
+        slots_[slot] = nullptr;
+        for (Timer* timer = head; timer != nullptr; timer = timer->next_) {
+            timer->slot_ = slot_count_;
+        }
+        slots_[slot_count_] = head;
+
+        while (slots_[slot_count_] != nullptr) {
+            Timer* timer = slots_[slot_count_];
+            remove(timer);
+
+            const std::uint64_t deadline = timer->last_activity_ + timer->timeout_;
+            if (timer->deadline_ > current_tick_ || deadline > current_tick_) {
+                link(timer, (std::max)(timer->deadline_, deadline));
+                continue;
+            }
+
+            // The object may disarm or re-arm any timeout, including the ones still in the expiring list.
+            static_cast<T&>(*timer).handle_timeout();
+        }
+    }
+
+    void link(Timer* timer, std::uint64_t deadline) {
+        const std::size_t slot = static_cast<std::size_t>(deadline % slot_count_);
+        timer->wheel_ = this;
+        timer->deadline_ = deadline;
+        timer->slot_ = slot;
+        timer->previous_ = nullptr;
+        timer->next_ = slots_[slot];
+        if (slots_[slot] != nullptr) {
+            slots_[slot]->previous_ = timer;
+        }
+        slots_[slot] = timer;
+        ++size_;
+    }
+
+    void remove(Timer* timer) {
+        if (timer->previous_ != nullptr) {
+            timer->previous_->next_ = timer->next_;
+        }
+        else {
+            slots_[timer->slot_] = timer->next_;
+        }
+        if (timer->next_ != nullptr) {
+            timer->next_->previous_ = timer->previous_;
+        }
+        timer->wheel_ = nullptr;
+        timer->previous_ = nullptr;
+        timer->next_ = nullptr;
+        --size_;
+    }
+
+    boost::asio::steady_timer timer_;
+    std::chrono::milliseconds tick_;
+    std::vector<Timer*> slots_; // One list per slot, followed by the list of timeouts being expired.
+    std::size_t slot_count_;
+    std::size_t size_ = 0;
+    std::uint64_t current_tick_ = 0;
+    std::chrono::steady_clock::time_point next_tick_time_;
+    bool running_ = false;
+};
@@ -0,0 +1,53 @@
+/*
+ * TokenBucket.cpp
+ * Purpose: Token bucket rate limiter. Tokens accrue at a fixed rate up to the burst size and every
+ *          admitted unit of work takes some; the bucket is refilled lazily from the time elapsed since
+ *          the last call, so it needs no timer. A bucket is used from one thread only.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#include "TokenBucket.h"
+
+#include <algorithm>
+
+TokenBucket::TokenBucket(double rate, double burst) {
+    configure(rate, burst);
+}
+
+void TokenBucket::configure(double rate, double burst) {
+    const bool was_unlimited = rate_ == 0.0;
+    refill();
+    rate_ = (std::max)(rate, 0.0);
+    burst_ = (std::max)(burst, 1.0);
+    tokens_ = was_unlimited ? burst_ : (std::min)(tokens_, burst_);
+}
+
+bool TokenBucket::try_consume(double tokens) {
+    if (rate_ == 0.0) {
+        return true;
+    }
+
+    refill();
+    if (tokens_ < tokens) {
+        return false;
+    }
+    tokens_ -= tokens;
+    return true;
+}
+
+double TokenBucket::rate() const {
+    return rate_;
+}
+
+double TokenBucket::burst() const {
+    return burst_;
+}
+
+void TokenBucket::refill() {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - last_refill_;
+    last_refill_ = now;
+    tokens_ = (std::min)(burst_, tokens_ + elapsed.count() * rate_);
+}
@@ -0,0 +1,70 @@
+/*
+ * TokenBucket.h
+ * Purpose: Token bucket rate limiter. Tokens accrue at a fixed rate up to the burst size and every
+ *          admitted unit of work takes some; the bucket is refilled lazily from the time elapsed since
+ *          the last call, so it needs no timer. A bucket is used from one thread only.
+ *
+ * Version: 1.0
+ * Date: 16.10.2026
+ */
+
+#pragma once
+#include <chrono>
+
+class TokenBucket {
+public:
+    /*
+     * Constructor for an unlimited bucket, which admits everything.
+     */
+    TokenBucket() = default;
+
+    /*
+     * Constructor for the TokenBucket class. The bucket starts full.
+     *
+     * @param[in] rate: The tokens added per second; zero makes the bucket unlimited.
+     * @param[in] burst: The maximum number of tokens, at least one.
+     */
+    TokenBucket(double rate, double burst);
+
+    /*
+     * Changes the rate and burst size, keeping the tokens collected so far up to the new burst size.
+     * A bucket that was unlimited starts full.
+     *
+     * @param[in] rate: The tokens added per second; zero makes the bucket unlimited.
+     * @param[in] burst: The maximum number of tokens, at least one.
+     */
+    void configure(double rate, double burst);
+
+    /*
+     * Takes tokens from the bucket if it holds enough.
+     *
+     * @param[in] tokens: The number of tokens to take.
+     * @return True if they were taken, false if the bucket holds fewer.
+     */
+    bool try_consume(double tokens = 1.0);
+
+    /*
+     * Get the rate of the bucket.
+     *
+     * @return The tokens added per second, zero if the bucket is unlimited.
+     */
+    double rate() const;
+
+    /*
+     * Get the burst size of the bucket.
+     *
+     * @return The maximum number of tokens.
+     */
+    double burst() const;
+
+private:
+    /*
+     * Adds the tokens accrued since the last refill.
+     */
+    void refill();
+
+    double rate_ = 0.0;
+    double burst_ = 0.0;
+    double tokens_ = 0.0;
+    std::chrono::steady_clock::time_point last_refill_;
+};
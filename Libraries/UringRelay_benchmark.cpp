@@ -0,0 +1,146 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <sys/resource.h>
+
+#include "./UringRelay.h"
+
+using boost::asio::ip::tcp;
+
+// Chunks a direction of the io_uring relay may hold ahead of its sends, the default pipeline depth of the proxy.
+const std::size_t MAX_PENDING_CHUNKS = 2;
+
+// Two connected loopback sockets: one stays with the relay, the other with a source or sink thread.
+std::pair<tcp::socket, tcp::socket> connected_pair(boost::asio::io_context& io_context, tcp::acceptor& acceptor)
+{
+    tcp::socket outer(io_context);
+    outer.connect(acceptor.local_endpoint());
+    tcp::socket inner(io_context);
+    acceptor.accept(inner);
+    return { std::move(inner), std::move(outer) };
+}
+
+// Minimal reactor-driven relay of one direction, as the copy engine does it: read, write, repeat.
+struct Copy_Direction : std::enable_shared_from_this<Copy_Direction>
+{
+    Copy_Direction(tcp::socket& from, tcp::socket& to)
+        : from(from), to(to), buffer(64 * 1024)
+    {
+    }
+
+    void read()
+    {
+        from.async_read_some(boost::asio::buffer(buffer),
+            [self = shared_from_this()](const boost::system::error_code& error, std::size_t length) {
+                if (error)
+                {
+                    boost::system::error_code ignored;
+                    self->to.shutdown(tcp::socket::shutdown_send, ignored);
+                    return;
+                }
+                boost::asio::async_write(self->to, boost::asio::buffer(self->buffer.data(), length),
+                    [self](const boost::system::error_code& error, std::size_t) {
+                        if (!error)
+                        {
+                            self->read();
+                        }
+                    });
+            });
+    }
+
+    tcp::socket& from;
+    tcp::socket& to;
+    std::vector<char> buffer;
+};
+
+double cpu_seconds()
+{
+    rusage usage = {};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Pushes bytes_per_tunnel through every tunnel and reports throughput and the CPU time of the relaying thread.
+void run(const char* name, bool use_uring, std::size_t tunnel_count, std::size_t bytes_per_tunnel)
+{
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor(io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+    UringRelay uring_relay(io_context);
+    if (use_uring && !uring_relay.open())
+    {
+        std::cout << name << ": io_uring is unavailable" << std::endl;
+        return;
+    }
+
+    std::vector<std::pair<tcp::socket, tcp::socket>> sources;
+    std::vector<std::pair<tcp::socket, tcp::socket>> sinks;
+    for (std::size_t i = 0; i < tunnel_count; i++)
+    {
+        sources.push_back(connected_pair(io_context, acceptor));
+        sinks.push_back(connected_pair(io_context, acceptor));
+    }
+
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    const double cpu_start = cpu_seconds();
+    for (std::size_t i = 0; i < tunnel_count; i++)
+    {
+        threads.emplace_back([&socket = sources[i].second, bytes_per_tunnel] {
+            const std::vector<char> chunk(1024 * 1024, 'x');
+            for (std::size_t sent = 0; sent < bytes_per_tunnel; sent += chunk.size())
+            {
+                boost::asio::write(socket, boost::asio::buffer(chunk));
+            }
+            socket.shutdown(tcp::socket::shutdown_send);
+        });
+        threads.emplace_back([&socket = sinks[i].second] {
+            std::vector<char> chunk(1024 * 1024);
+            boost::system::error_code error;
+            while (!error)
+            {
+                socket.read_some(boost::asio::buffer(chunk), error);
+            }
+            socket.close();
+        });
+
+        if (use_uring)
+        {
+            uring_relay.relay(sources[i].first.native_handle(), sinks[i].first.native_handle(), MAX_PENDING_CHUNKS, [] {});
+        }
+        else
+        {
+            std::make_shared<Copy_Direction>(sources[i].first, sinks[i].first)->read();
+        }
+    }
+    io_context.run();
+    const double cpu = cpu_seconds() - cpu_start;
+    const auto end = std::chrono::steady_clock::now();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ", " << tunnel_count << " tunnel(s): "
+        << tunnel_count * bytes_per_tunnel / seconds / 1e6 << " MB/s, relay CPU "
+        << cpu / seconds * 100 << " %" << std::endl;
+}
+
+int main()
+{
+    const std::size_t total_bytes = std::size_t(4) * 1024 * 1024 * 1024;
+
+    for (std::size_t tunnel_count : { 1, 16, 256 })
+    {
+        run("Copy relay", false, tunnel_count, total_bytes / tunnel_count);
+        run("io_uring relay", true, tunnel_count, total_bytes / tunnel_count);
+    }
+
+    return 0;
+}
@@ -9,46 +9,106 @@
 
 #include "Username_Password.h"
 
-Username_Password::Username_Password(const std::string username, const std::string password) : username(username), password(password) {}
+Username_Password::Username_Password(const std::string username, const std::string password) : username(username), password(password), socket(nullptr), buffer(nullptr), username_length(0), password_length(0) {}
 
-Authentication_Result Username_Password::authenticate(boost::asio::ip::tcp::socket socket)
+void Username_Password::async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer, Authentication_Handler handler)
 {
-    const std::array<unsigned char, 2> response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0x02) };
-    boost::asio::write(socket, boost::asio::buffer(response));
+    this->socket = &socket;
+    this->buffer = &buffer;
+    this->handler = std::move(handler);
 
-    std::array<unsigned char, 2> header;
-    boost::asio::read(socket, boost::asio::buffer(header));
-    if (header[0] != 0x01)
-    {
-        Authentication_Result result = { false, std::move(socket), 2, "Invalid authentication request header." };
-        return result;
-    }
+    response = { static_cast<unsigned char>(5), static_cast<unsigned char>(0x02) };
+    boost::asio::async_write(socket, boost::asio::buffer(response),
+        [self = shared_from_this(), this](const boost::system::error_code& error, std::size_t)
+        {
+            if (error)
+            {
+                fail("Error while sending method selection: " + error.message());
+                return;
+            }
 
-    const unsigned char username_length = header[1];
-    std::vector<unsigned char> username_read(username_length);
-    boost::asio::read(socket, boost::asio::buffer(username_read));
+            read_header();
+        });
+}
 
-    unsigned char password_length;
-    boost::asio::read(socket, boost::asio::buffer(&password_length, 1));
+void Username_Password::read_header()
+{
+    // The sub-negotiation may have arrived together with the greeting; the buffer is only read into when it is incomplete.
+    buffer->async_fill(*socket, 2,
+        [self = shared_from_this(), this](const boost::system::error_code& error)
+        {
+            if (error)
+            {
+                fail("Error while reading authentication request header: " + error.message());
+                return;
+            }
+
+            if (buffer->data()[0] != 0x01)
+            {
+                fail("Invalid authentication request header.");
+                return;
+            }
+
+            username_length = buffer->data()[1];
+            read_username();
+        });
+}
+
+void Username_Password::read_username()
+{
+    buffer->async_fill(*socket, 2 + username_length + 1,
+        [self = shared_from_this(), this](const boost::system::error_code& error)
+        {
+            if (error)
+            {
+                fail("Error while reading username: " + error.message());
+                return;
+            }
 
-    std::vector<unsigned char> password_read(password_length);
-    boost::asio::read(socket, boost::asio::buffer(password_read));
+            password_length = buffer->data()[2 + username_length];
+            read_password();
+        });
+}
 
-    const std::string username_str(username_read.begin(), username_read.end());
-    const std::string password_str(password_read.begin(), password_read.end());
+void Username_Password::read_password()
+{
+    const std::size_t request_length = 2 + username_length + 1 + password_length;
+    buffer->async_fill(*socket, request_length,
+        [self = shared_from_this(), this, request_length](const boost::system::error_code& error)
+        {
+            if (error)
+            {
+                fail("Error while reading password: " + error.message());
+                return;
+            }
 
-    if ((username_str == username) && (password_str == password))
-    {
-        const std::array<unsigned char, 2> successful = { static_cast<unsigned char>(0x01), static_cast<unsigned char>(0x00) };
-        boost::asio::write(socket, boost::asio::buffer(successful));
+            const unsigned char* request = buffer->data();
+            const std::string username_str(request + 2, request + 2 + username_length);
+            const std::string password_str(request + 2 + username_length + 1, request + request_length);
+            buffer->consume(request_length);
 
-        Authentication_Result result = { true, std::move(socket), 2, "" };
-        return result;
-    }
+            send_status((username_str == username) && (password_str == password));
+        });
+}
+void Username_Password::send_status(const bool authenticated)
+{
+    response = { static_cast<unsigned char>(0x01), static_cast<unsigned char>(authenticated ? 0x00 : 0x01) };
+    boost::asio::async_write(*socket, boost::asio::buffer(response),
+        [self = shared_from_this(), this, authenticated](const boost::system::error_code& error, std::size_t)
+        {
+            if (error)
+            {
+                fail("Error while sending authentication status: " + error.message());
+                return;
+            }
 
-    const std::array<unsigned char, 2> successful = { static_cast<unsigned char>(0x01), static_cast<unsigned char>(0x01) };
-    boost::asio::write(socket, boost::asio::buffer(successful));
+            const Authentication_Handler completion = std::move(handler);
+            completion({ authenticated, 2, "", authenticated ? username : "" });
+        });
+}
 
-    Authentication_Result result = { false, std::move(socket), 2, "" };
-    return result;
+void Username_Password::fail(const std::string& error)
+{
+    const Authentication_Handler completion = std::move(handler);
+    completion({ false, 2, error });
 }
\ No newline at end of file
@@ -29,10 +29,48 @@ public:
     Username_Password(const std::string username, const std::string password);
 
     /*
-     * Authenticate method for the username and password strategy.
+     * Asynchronous authentication for the username and password strategy (RFC 1929 sub-negotiation).
      *
      * @param[in] socket: The socket to authenticate.
-     * @return `Authentication_Result` struct indicating whether authentication is successful and associated details.
+     * @param[in] buffer: The handshake buffer.
+     * @param[in] handler: The handler receiving the `Authentication_Result` of the exchange.
      */
-    Authentication_Result authenticate(boost::asio::ip::tcp::socket socket) override;
+    void async_authenticate(boost::asio::ip::tcp::socket& socket, Handshake_Buffer& buffer, Authentication_Handler handler) override;
+
+private:
+    /*
+     * Parses the sub-negotiation header: version and username length.
+     */
+    void read_header();
+
+    /*
+     * Parses the password length, which follows the username.
+     */
+    void read_username();
+
+    /*
+     * Parses the password and verifies the received credentials.
+     */
+    void read_password();
+
+    /*
+     * Sends the sub-negotiation status and completes the exchange.
+     *
+     * @param[in] authenticated: Whether the received credentials were valid.
+     */
+    void send_status(const bool authenticated);
+
+    /*
+     * Completes the exchange with an error.
+     *
+     * @param[in] error: The description of the error.
+     */
+    void fail(const std::string& error);
+
+    boost::asio::ip::tcp::socket* socket;
+    Handshake_Buffer* buffer;
+    Authentication_Handler handler;
+    std::array<unsigned char, 2> response;
+    std::size_t username_length;
+    std::size_t password_length;
 };
\ No newline at end of file
@@ -60,8 +60,12 @@
 
 #include <iostream>
 #include <fstream>
+#include <atomic>
+#include <mutex>
 
 #include "Libraries/ProxyServer.h"
+#include "Libraries/ConfigWatcher.h"
+#include "Libraries/Metrics.h"
 
 // Service status variables
 SERVICE_STATUS service_status = { 0 };
@@ -72,9 +76,33 @@ void WINAPI service_main(DWORD argc, LPWSTR* argv);
 void WINAPI service_ctrl_handler(DWORD);
 void report_service_status(DWORD, DWORD, DWORD);
 
+// Guards the service objects below, which service_main publishes together once all of them are created
+std::mutex service_mutex;
+
 // Shared pointer to the ProxyServer instance
 std::shared_ptr<ProxyServer> server;
 
+// Shared pointer to the pool of io_contexts running the ProxyServer shards
+std::shared_ptr<IoContextPool> io_context_pool;
+
+// Shared pointer to the watcher reloading the policy when config.ini changes
+std::shared_ptr<ConfigWatcher> config_watcher;
+
+// Set by a stop that arrives while service_main is still creating the ProxyServer; guarded by service_mutex
+bool stop_requested = false;
+
+// Set by the first of the service stop, the listener handoff and the error path to shut the service down
+std::atomic<bool> shutdown_claimed(false);
+
+// Claims the shutdown of the service, so only one thread stops the watcher, the server and the pool
+bool claim_shutdown()
+{
+    return !shutdown_claimed.exchange(true);
+}
+
+// Path of the configuration file
+const std::string config_path = "C:\\Proxy_server\\config.ini";
+
 // Log file for service messages
 std::ofstream log_file("C:\\Proxy_server\\service_log.txt", std::ios::out);
 
@@ -123,31 +151,111 @@ void service_main(DWORD argc, LPWSTR* argv)
     report_service_status(SERVICE_RUNNING, NO_ERROR, 0);
     log_file << "Service started." << std::endl;
 
+    // Created here and published to the control handler only once all of them exist
+    std::shared_ptr<IoContextPool> pool;
+    std::shared_ptr<ProxyServer> proxy_server;
+    std::shared_ptr<ConfigWatcher> watcher;
+
     try
     {   
-        // Initialize Boost.Asio io_context and proxy configuration
-        boost::asio::io_context io_context;
+        // Initialize proxy configuration and the pool of Boost.Asio io_contexts
         ProxyConfiguration proxyConfig;
-        proxyConfig.loadConfigFromIni("C:\\Proxy_server\\config.ini");
+        proxyConfig.loadConfigFromIni(config_path);
+        pool = std::make_shared<IoContextPool>(proxyConfig.getNumIoThreads() > 0 ? proxyConfig.getNumIoThreads() : 0, proxyConfig.getCpuAffinity());
 
         // Initialize logger and database
-        std::shared_ptr<Logger> logger = std::make_shared<Logger>(2, proxyConfig.getLogFilesDir());
-        std::shared_ptr<Database> database = std::make_shared<Database>(2, proxyConfig.getDbFilesDir());
+        const std::size_t queue_capacity = static_cast<std::size_t>((std::max)(1, proxyConfig.getLogQueueCapacity()));
+        std::shared_ptr<Logger> logger = std::make_shared<Logger>(2, proxyConfig.getLogFilesDir(), queue_capacity);
+        std::shared_ptr<Database> database = std::make_shared<Database>(2, proxyConfig.getDbFilesDir(), queue_capacity,
+            static_cast<std::size_t>((std::max)(1, proxyConfig.getDbBatchSize())), std::chrono::milliseconds((std::max)(0, proxyConfig.getDbFlushIntervalMs())));
 
         // Create and start the ProxyServer instance
-        server = std::make_shared<ProxyServer>(io_context, proxyConfig.getProxyServerIp(), proxyConfig.getProxyServerPort(), proxyConfig, proxyConfig.getLoggingMethod(), logger, database);
-        std::cout << "Proxy server started. Listening on " << proxyConfig.getProxyServerIp() << ":" << proxyConfig.getProxyServerPort() << std::endl;
+        proxy_server = std::make_shared<ProxyServer>(*pool, proxyConfig.getProxyServerIp(), proxyConfig.getProxyServerPort(), proxyConfig, proxyConfig.getLoggingMethod(), logger, database);
+        std::cout << "Proxy server started. Listening on " << proxyConfig.getProxyServerIp() << ":" << proxyConfig.getProxyServerPort() << " with " << pool->size() << " io threads" << std::endl;
+
+        // Apply ACL and credential changes to new connections without restarting the service
+        if (proxyConfig.getConfigHotReload())
+        {
+            watcher = std::make_shared<ConfigWatcher>(config_path, [weak_server = std::weak_ptr<ProxyServer>(proxy_server)](std::shared_ptr<const Policy> policy) {
+                if (std::shared_ptr<ProxyServer> reloaded = weak_server.lock())
+                {
+                    reloaded->update_policy(std::move(policy));
+                }
+            }, logger);
+            watcher->start();
+        }
+
+        // Once a new process took the listening sockets over and the open tunnels drained, stop like on a service stop
+        // The handler is held by the server, so it must not keep the pool, whose io_contexts the server's acceptors belong to, alive
+        proxy_server->set_handoff_handler([weak_pool = std::weak_ptr<IoContextPool>(pool), watcher] {
+            if (claim_shutdown())
+            {
+                if (watcher)
+                {
+                    watcher->stop();
+                }
+                if (std::shared_ptr<IoContextPool> stopped = weak_pool.lock())
+                {
+                    stopped->stop();
+                }
+            }
+        });
+
+        // A stop that came in while the objects were being created found nothing to drain, so it is carried out here
+        bool stop_now = false;
+        {
+            std::lock_guard<std::mutex> lock(service_mutex);
+            io_context_pool = pool;
+            server = proxy_server;
+            config_watcher = watcher;
+            stop_now = stop_requested && claim_shutdown();
+        }
+        if (stop_now)
+        {
+            if (watcher)
+            {
+                watcher->stop();
+            }
+            proxy_server->stop();
+            pool->stop();
+        }
 
-        io_context.run();
+        pool->run();
     }
     catch (std::exception& e)
     {
-        // Stop the server and log any exceptions
-        server->stop();
+        // Stop whatever was started before the exception, unless a stop is already under way, and log it
+        if (claim_shutdown())
+        {
+            if (watcher)
+            {
+                watcher->stop();
+            }
+            if (proxy_server)
+            {
+                proxy_server->stop();
+            }
+            if (pool)
+            {
+                pool->stop();
+            }
+        }
         log_file << "Exception: " << e.what() << std::endl;
     }
 
+    // The server and the watcher are destroyed first, while the io_contexts their sockets and timers belong to still exist
+    {
+        std::lock_guard<std::mutex> lock(service_mutex);
+        server.reset();
+        config_watcher.reset();
+        io_context_pool.reset();
+    }
+    proxy_server.reset();
+    watcher.reset();
+    pool.reset();
+
     // Report service stopped and close the log file
+    log_file << Metrics::instance().report();
     report_service_status(SERVICE_STOPPED, NO_ERROR, 0);
     log_file << "Service stoped." << std::endl;
 
@@ -163,17 +271,46 @@ void WINAPI service_ctrl_handler(DWORD ctrl)
     switch (ctrl)
     {
     case SERVICE_CONTROL_STOP:
-        // Report service stop pending, stop the server, and log the service stop
-        report_service_status(SERVICE_STOP_PENDING, NO_ERROR, 3000);
-        server->stop();
-        log_file << "Service stoped." << std::endl;
+    {
+        std::shared_ptr<IoContextPool> pool;
+        std::shared_ptr<ProxyServer> proxy_server;
+        std::shared_ptr<ConfigWatcher> watcher;
+        {
+            std::lock_guard<std::mutex> lock(service_mutex);
+            stop_requested = true;
+            pool = io_context_pool;
+            proxy_server = server;
+            watcher = config_watcher;
+        }
+
+        // Before the server exists there is nothing to drain yet; service_main stops it as soon as it is created
+        if (!proxy_server)
+        {
+            report_service_status(SERVICE_STOP_PENDING, NO_ERROR, 10000);
+            break;
+        }
 
-        if (log_file.is_open())
+        const std::chrono::seconds drain_timeout = proxy_server->get_policy()->drain_timeout();
+        report_service_status(SERVICE_STOP_PENDING, NO_ERROR, static_cast<DWORD>(drain_timeout.count()) * 1000 + 3000);
+
+        // Stop accepting and let the open tunnels finish on their reactor threads; once they have, the pool
+        // returns and service_main reports the service stopped. A handoff or error already stopping the service
+        // stops the pool on its own.
+        if (claim_shutdown())
         {
-            log_file.close();
+            if (watcher)
+            {
+                watcher->stop();
+            }
+            proxy_server->drain(drain_timeout, [weak_pool = std::weak_ptr<IoContextPool>(pool)] {
+                if (std::shared_ptr<IoContextPool> stopped = weak_pool.lock())
+                {
+                    stopped->stop();
+                }
+            });
         }
-        report_service_status(SERVICE_STOPPED, NO_ERROR, 0);
         break;
+    }
 
     default:
         break;